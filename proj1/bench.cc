@@ -0,0 +1,51 @@
+// Scaling benchmark of ConcurrentFingerprintSet: the same number of
+// fingerprints, half of them seen twice, inserted by 1, 2, 4, ... threads.
+//   bench-bin [NB_INSERTS [MAX_THREADS]]
+#include "fingerprint-set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static std::uint64_t splitmix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+int main(int argc, char *argv[]) {
+    size_t nb_inserts = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t{1} << 24;
+    unsigned max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    max_threads = std::max(1u, max_threads);
+
+    std::cout << "threads  Minserts/s  speedup\n";
+    double single_rate = 0;
+    for (unsigned nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+        // distinct fingerprints take at most half of it, far from full
+        ConcurrentFingerprintSet set(nb_inserts * 2 * sizeof(std::uint64_t));
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < nb_threads; ++t) {
+            threads.emplace_back([&set, t, nb_threads, nb_inserts]() {
+                for (size_t i = t; i < nb_inserts; i += nb_threads)
+                    set.insert(splitmix(i / 2));
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - t0;
+
+        double rate = nb_inserts / elapsed.count() / 1e6;
+        if (nb_threads == 1)
+            single_rate = rate;
+        std::cout << nb_threads << "\t " << rate << "\t     " << rate / single_rate << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "search-strategies.h"
+#include "packed-move.h"
+#include "packed-state.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The backward search walks the raw move graph: unlike SearchState, its
+// states are not closed under the safe moves to the homes, as it starts from
+// the solved position where every card is home. A backward step undoes one
+// forward move: the top card c of some storage B goes back to a free cell or
+// work stack A, provided the forward move A -> B is legal afterwards, i.e.
+// B is a home or free cell, or c could sit on the new top of work stack B.
+//
+// Both searches meet on keys of closed states: a raw state R meets the
+// forward state F if F and R after its safe moves pack to the same bytes
+// (free cells canonicalized). The forward moves undone on the way from the
+// goal to R then lead F home, once the cards which the safe moves of the
+// forward search have taken home in the meantime are skipped (see
+// reconstruct_()).
+
+static constexpr std::uint32_t no_parent = UINT32_MAX;
+
+struct BidirectionalSearch::ForwardNode {
+    std::uint32_t parent;
+    PackedMove move;
+};
+
+// a forward move from this state leads to the parent, one step closer to the goal
+struct BidirectionalSearch::BackwardNode {
+    std::uint32_t parent;
+    std::uint8_t card;  // see cardIndex()
+    PackedMove move;
+};
+
+namespace {
+
+PackedState closedKey(const GameState &raw) {
+    GameState closed(raw);
+    runSafeMoves(closed);
+    return canonicalFreeCells(packState(closed));
+}
+
+GameState solvedGame() {
+    GameState gs;
+    for (size_t i = 0; i < colors_list.size(); ++i) {
+        for (int value = 1; value <= king_value; ++value)
+            gs.homes[i].acceptCard({colors_list[i], value});
+    }
+
+    return gs;
+}
+
+// Predecessors of a raw state, each with the forward move leading back to it.
+template <typename Callback>
+void forEachReverseMove(const GameState &gs, Callback callback) {
+    long empty_cell = -1;  // free cells are interchangeable, one is enough
+    for (long i = nb_freecells - 1; i >= 0; --i) {
+        if (!gs.free_cells[i].topCard().has_value())
+            empty_cell = i;
+    }
+
+    for (const CardStorage *from : gs.all_storage) {
+        auto opt_card = from->topCard();
+        if (!opt_card.has_value())
+            continue;
+        Card card = *opt_card;
+
+        Location from_loc = locFromPtr(gs, from);
+        if (from_loc.cl == LocationClass::Stacks) {
+            const auto &cards = gs.stacks[from_loc.id].storage();
+            if (cards.size() > 1 && !WorkStack::canSitOn(cards[cards.size() - 2], card))
+                continue;
+        }
+
+        auto undo = [&](Location to_loc) {
+            GameState pred(gs);
+            const_cast<CardStorage *>(ptrFromLoc(pred, from_loc))->getCard();
+            if (to_loc.cl == LocationClass::FreeCells)
+                pred.free_cells[to_loc.id].acceptCard(card);
+            else
+                pred.stacks[to_loc.id].forceCard(card);
+
+            callback(std::move(pred), card, PackedMove(to_loc, from_loc));
+        };
+
+        if (empty_cell >= 0 && from_loc.cl != LocationClass::FreeCells)
+            undo({LocationClass::FreeCells, empty_cell});
+        for (long i = 0; i < nb_stacks; ++i) {
+            if (from_loc != Location{LocationClass::Stacks, i})
+                undo({LocationClass::Stacks, i});
+        }
+    }
+}
+
+}
+
+std::vector<SearchAction> BidirectionalSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+    stats_ = {};
+    if (init_state.isFinal())
+        return {};
+
+    std::vector<ForwardNode> forward_nodes{{no_parent, PackedMove()}};
+    std::unordered_map<PackedState, std::uint32_t, PackedStateHash> forward_seen;
+    std::vector<std::pair<SearchState, std::uint32_t>> forward_layer{{init_state, 0}};
+    forward_seen.emplace(canonicalFreeCells(packState(init_state)), 0);
+
+    GameState goal = solvedGame();
+    std::vector<BackwardNode> backward_nodes{{no_parent, 0, PackedMove()}};
+    std::unordered_map<PackedState, std::uint32_t, PackedStateHash> backward_seen;
+    std::unordered_map<PackedState, std::uint32_t, PackedStateHash> backward_closed;  // closed key -> first raw node
+    std::vector<std::pair<GameState, std::uint32_t>> backward_layer;
+    backward_layer.emplace_back(goal, 0);
+    backward_seen.emplace(canonicalFreeCells(packState(goal)), 0);
+    backward_closed.emplace(closedKey(goal), 0);
+
+    while (!forward_layer.empty() && !backward_layer.empty()) {
+        // the cheaper side goes one layer deeper
+        if (forward_layer.size() <= backward_layer.size()) {
+            std::vector<std::pair<SearchState, std::uint32_t>> next_layer;
+            for (const auto &[state, node] : forward_layer) {
+                if (cancel.memoryCheck() == CancellationToken::MemVerdict::GiveUp || cancel.expand())
+                    return {};
+
+                for (const auto &action : state.actions()) {
+                    SearchState next = action.execute(state);
+                    stats_.nb_generated++;
+                    if (next.isDeadEnd()) {
+                        stats_.nb_pruned++;
+                        continue;
+                    }
+
+                    auto key = canonicalFreeCells(packState(next));
+                    if (!forward_seen.emplace(key, forward_nodes.size()).second)
+                        continue;
+                    forward_nodes.push_back({node, PackedMove(action)});
+
+                    auto meeting = backward_closed.find(key);
+                    if (meeting != backward_closed.end())
+                        return reconstruct_(init_state, forward_nodes, forward_nodes.size() - 1, backward_nodes, meeting->second);
+
+                    next_layer.emplace_back(std::move(next), forward_nodes.size() - 1);
+                }
+            }
+            forward_layer = std::move(next_layer);
+        } else {
+            std::vector<std::pair<GameState, std::uint32_t>> next_layer;
+            for (const auto &[raw, node] : backward_layer) {
+                if (cancel.memoryCheck() == CancellationToken::MemVerdict::GiveUp || cancel.expand())
+                    return {};
+
+                std::optional<std::uint32_t> meeting_forward;
+                forEachReverseMove(raw, [&](GameState &&pred, const Card &card, PackedMove move) {
+                    if (meeting_forward.has_value())
+                        return;
+                    stats_.nb_generated++;
+
+                    if (!backward_seen.emplace(canonicalFreeCells(packState(pred)), backward_nodes.size()).second)
+                        return;
+                    backward_nodes.push_back({node, static_cast<std::uint8_t>(cardIndex(card)), move});
+
+                    auto key = closedKey(pred);
+                    auto meeting = forward_seen.find(key);
+                    if (meeting != forward_seen.end())
+                        meeting_forward = meeting->second;
+                    backward_closed.emplace(key, backward_nodes.size() - 1);
+
+                    next_layer.emplace_back(std::move(pred), backward_nodes.size() - 1);
+                });
+
+                if (meeting_forward.has_value())
+                    return reconstruct_(init_state, forward_nodes, *meeting_forward, backward_nodes, backward_nodes.size() - 1);
+            }
+            backward_layer = std::move(next_layer);
+        }
+
+        stats_.peak_open = std::max(stats_.peak_open, forward_layer.size() + backward_layer.size());
+        stats_.peak_closed = std::max(stats_.peak_closed, forward_seen.size() + backward_seen.size());
+    }
+
+    return {};
+}
+
+std::vector<SearchAction> BidirectionalSearch::reconstruct_(
+        const SearchState &init_state,
+        const std::vector<ForwardNode> &forward_nodes, std::uint32_t forward_meeting,
+        const std::vector<BackwardNode> &backward_nodes, std::uint32_t backward_meeting
+    ) {
+    std::vector<SearchAction> solution;
+    for (auto node = forward_meeting; forward_nodes[node].parent != no_parent; node = forward_nodes[node].parent)
+        solution.push_back(forward_nodes[node].move.action());
+    std::reverse(solution.begin(), solution.end());
+
+    SearchState state(init_state);
+    for (const auto &action : solution) {
+        if (!state.execute(action))
+            return {};
+    }
+
+    // The backward chain was found on raw states, where the homes are in
+    // colors_list order and free cells may be used in another order.
+    // The safe moves only ever took to the homes cards on top of what the
+    // chain moves next, so it stays legal once these cards are skipped.
+    for (auto node = backward_meeting; backward_nodes[node].parent != no_parent; node = backward_nodes[node].parent) {
+        const auto &step = backward_nodes[node];
+        const GameState &gs = state.state_;
+        Card card = cardFromIndex(step.card);
+        if (cardIsHome(gs, card))
+            continue;
+
+        Location from = step.move.from();
+        Location to = step.move.to();
+        if (from.cl == LocationClass::FreeCells) {
+            auto cell = std::find_if(gs.free_cells.begin(), gs.free_cells.end(),
+                [&](const FreeCell &fc) { return fc.topCard() == card; });
+            if (cell == gs.free_cells.end())
+                return {};
+            from = locFromPtr(gs, &*cell);
+        }
+
+        if (to.cl == LocationClass::FreeCells) {
+            auto cell = std::find_if(gs.free_cells.begin(), gs.free_cells.end(),
+                [](const FreeCell &fc) { return !fc.topCard().has_value(); });
+            if (cell == gs.free_cells.end())
+                return {};
+            to = locFromPtr(gs, &*cell);
+        } else if (to.cl == LocationClass::Homes) {
+            auto home = findHomeFor(gs, card);
+            if (home == gs.homes.end())
+                return {};
+            to = locFromPtr(gs, &*home);
+        }
+
+        SearchAction action(from, to);
+        if (!state.execute(action))
+            return {};
+        solution.push_back(action);
+    }
+
+    return state.isFinal() ? solution : std::vector<SearchAction>{};
+}
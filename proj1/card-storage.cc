@@ -120,7 +120,7 @@ std::ostream& operator<< (std::ostream& os, const FreeCell & fc) {
 }
 
 bool WorkStack::canSitOn(const Card &base, const Card &candidate) {
-	bool oppposing_render_color = render_color_map.at(candidate.color) != render_color_map.at(base.color);
+	bool oppposing_render_color = renderColor(candidate.color) != renderColor(base.color);
 	bool one_less = candidate.value == base.value - 1;
 	return oppposing_render_color && one_less;
 }
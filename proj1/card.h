@@ -16,6 +16,11 @@ extern const std::map<Color, std::string> color_map;
 
 extern const std::map<Color, RenderColor> render_color_map;
 
+// same as render_color_map.at(color), without the map lookup on hot paths
+inline RenderColor renderColor(Color color) {
+	return (color == Color::Heart || color == Color::Diamond) ? RenderColor::Red : RenderColor::Black;
+}
+
 inline constexpr int king_value = 13;
 
 struct Card {
@@ -0,0 +1,197 @@
+#include "closed-set.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool ExactClosedSet::contains(const SearchState &state) const {
+    return states_.count(state) > 0;
+}
+
+ClosedSetItf::Handle ExactClosedSet::insert(const SearchState &state, Handle) {
+    states_.insert(state);
+    return no_handle;
+}
+
+size_t ExactClosedSet::size() const {
+    return states_.size();
+}
+
+void ExactClosedSet::clear() {
+    states_ = {};
+}
+
+DeltaClosedSet::DeltaClosedSet(int keyframe_interval) :
+    keyframe_interval_(std::clamp(keyframe_interval, 1, 255)),  // chains fit in a byte
+    table_(1024, 0)
+{}
+
+DeltaClosedSet::Bytes DeltaClosedSet::bytes_(const SearchState &state) {
+    Bytes bytes;
+    PackedState packed = packState(state);
+    HomeOrder order = homeOrder(state);
+    std::copy(packed.begin(), packed.end(), bytes.begin());
+    std::copy(order.begin(), order.end(), bytes.begin() + nb_cards);
+    return bytes;
+}
+
+DeltaClosedSet::Bytes DeltaClosedSet::decode_(Handle index) const {
+    // deltas are applied from the keyframe up, so the chain is walked first
+    std::array<Handle, 256> chain;
+    size_t length = 0;
+    for (; entries_[index].base != no_handle; index = entries_[index].base)
+        chain[length++] = index;
+
+    Bytes bytes;
+    std::copy_n(data_.begin() + entries_[index].offset, bytes.size(), bytes.begin());
+    while (length > 0) {
+        const Entry &entry = entries_[chain[--length]];
+        for (size_t i = 0; i < entry.nb_changes; ++i)
+            bytes[data_[entry.offset + 2 * i]] = data_[entry.offset + 2 * i + 1];
+    }
+
+    return bytes;
+}
+
+size_t DeltaClosedSet::find_(std::uint64_t hash, const Bytes &bytes) const {
+    size_t mask = table_.size() - 1;
+    for (size_t i = (hash ^ (hash >> 32)) & mask; ; i = (i + 1) & mask) {
+        if (table_[i] == 0)
+            return i;
+
+        const Entry &entry = entries_[table_[i] - 1];
+        if (entry.hash == hash && decode_(table_[i] - 1) == bytes)
+            return i;
+    }
+}
+
+bool DeltaClosedSet::contains(const SearchState &state) const {
+    return table_[find_(hash(state), bytes_(state))] != 0;
+}
+
+ClosedSetItf::Handle DeltaClosedSet::insert(const SearchState &state, Handle parent) {
+    std::uint64_t state_hash = hash(state);
+    Bytes bytes = bytes_(state);
+    size_t slot = find_(state_hash, bytes);
+    if (table_[slot] != 0)
+        return table_[slot] - 1;
+
+    Entry entry{state_hash, data_.size(), no_handle, 0, 0};
+    if (parent != no_handle && entries_[parent].chain + 1 < keyframe_interval_) {
+        Bytes parent_bytes = decode_(parent);
+        size_t nb_changes = 0;
+        for (size_t i = 0; i < bytes.size(); ++i)
+            nb_changes += bytes[i] != parent_bytes[i];
+
+        // a delta of more than half the bytes would not save anything
+        if (2 * nb_changes < bytes.size()) {
+            entry.base = parent;
+            entry.nb_changes = nb_changes;
+            entry.chain = entries_[parent].chain + 1;
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                if (bytes[i] != parent_bytes[i]) {
+                    data_.push_back(i);
+                    data_.push_back(bytes[i]);
+                }
+            }
+        }
+    }
+    if (entry.base == no_handle)
+        data_.insert(data_.end(), bytes.begin(), bytes.end());
+
+    entries_.push_back(entry);
+    table_[slot] = entries_.size();
+    if (entries_.size() * 2 > table_.size())
+        grow_();
+
+    return entries_.size() - 1;
+}
+
+size_t DeltaClosedSet::size() const {
+    return entries_.size();
+}
+
+void DeltaClosedSet::clear() {
+    entries_ = {};
+    data_ = {};
+    table_.assign(1024, 0);
+    table_.shrink_to_fit();
+}
+
+void DeltaClosedSet::grow_() {
+    table_.assign(table_.size() * 2, 0);
+    size_t mask = table_.size() - 1;
+    for (size_t index = 0; index < entries_.size(); ++index) {
+        std::uint64_t hash = entries_[index].hash;
+        size_t i = (hash ^ (hash >> 32)) & mask;
+        while (table_[i] != 0)
+            i = (i + 1) & mask;
+        table_[i] = index + 1;
+    }
+}
+
+ApproxClosedSet::ApproxClosedSet(int log2_bits) :
+    nb_words_(std::size_t{1} << (std::clamp(log2_bits, 9, 40) - 6)),  // at least one block
+    nb_bits_set_(0),
+    size_(0)
+{}
+
+size_t ApproxClosedSet::block_(std::uint64_t hash) const {
+    return (hash % (nb_words_ / block_words)) * block_words;
+}
+
+std::uint64_t ApproxClosedSet::bits_(std::uint64_t hash) {
+    // remixed (splitmix64 finalizer), not to depend on the bits picking the block
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+std::uint64_t ApproxClosedSet::bit_(std::uint64_t bits, int word) {
+    return std::uint64_t{1} << ((bits >> (6 * word)) & 63);
+}
+
+bool ApproxClosedSet::contains(const SearchState &state) const {
+    if (words_.empty())
+        return false;
+
+    std::uint64_t state_hash = hash(state);
+    size_t block = block_(state_hash);
+    std::uint64_t bits = bits_(state_hash);
+    for (int i = 0; i < block_words; ++i)
+        if ((words_[block + i] & bit_(bits, i)) == 0)
+            return false;
+    return true;
+}
+
+ClosedSetItf::Handle ApproxClosedSet::insert(const SearchState &state, Handle) {
+    if (words_.empty())
+        words_.assign(nb_words_, 0);
+
+    std::uint64_t state_hash = hash(state);
+    size_t block = block_(state_hash);
+    std::uint64_t bits = bits_(state_hash);
+    size_t nb_new_bits = 0;
+    for (int i = 0; i < block_words; ++i) {
+        std::uint64_t bit = bit_(bits, i);
+        nb_new_bits += (words_[block + i] & bit) == 0;
+        words_[block + i] |= bit;
+    }
+
+    nb_bits_set_ += nb_new_bits;
+    size_ += nb_new_bits > 0;
+    return no_handle;
+}
+
+size_t ApproxClosedSet::size() const {
+    return size_;
+}
+
+void ApproxClosedSet::clear() {
+    words_ = {};
+    nb_bits_set_ = 0;
+    size_ = 0;
+}
+
+double ApproxClosedSet::falsePositiveRate() const {
+    return std::pow(static_cast<double>(nb_bits_set_) / (nb_words_ * 64), block_words);
+}
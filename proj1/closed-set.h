@@ -0,0 +1,129 @@
+#ifndef CLOSED_SET_H
+#define CLOSED_SET_H
+
+#include "search-interface.h"
+#include "packed-state.h"
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Set of states already seen by a search.
+// insert() takes the handle of the parent of the state, as returned when
+// the parent was inserted (or no_handle), and returns one for the state.
+// Implementations are free to make use of the parent, or to ignore it.
+class ClosedSetItf {
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle no_handle = UINT32_MAX;
+
+    virtual bool contains(const SearchState &state) const =0;
+    virtual Handle insert(const SearchState &state, Handle parent) =0;
+    virtual size_t size() const =0;
+    virtual void clear() =0;
+    virtual ~ClosedSetItf() {}
+
+    // probability that contains() mistakes a new state for a seen one
+    virtual double falsePositiveRate() const { return 0.0; }
+};
+
+// Clears the set when leaving the scope, so that a strategy owning it does
+// not hold on to the states of its last solve.
+class ClosedSetScope {
+public:
+    explicit ClosedSetScope(ClosedSetItf &closed) : closed_(closed) { closed_.clear(); }
+    ~ClosedSetScope() { closed_.clear(); }
+
+    ClosedSetScope(const ClosedSetScope &) = delete;
+    ClosedSetScope &operator=(const ClosedSetScope &) = delete;
+
+private:
+    ClosedSetItf &closed_;
+};
+
+// The whole states in a std::set, handles are not used.
+class ExactClosedSet : public ClosedSetItf {
+public:
+    bool contains(const SearchState &state) const override;
+    Handle insert(const SearchState &state, Handle parent) override;
+    size_t size() const override;
+    void clear() override;
+
+private:
+    std::set<SearchState> states_;
+};
+
+// Exact set storing every state as the bytes of its packed state (and home
+// order) which differ from those of its parent; a move and the safe moves
+// after it change a few bytes only. Every keyframe_interval-th state in a
+// chain of deltas, and any state without a parent, is stored in full.
+// Lookups compare 64-bit hashes first and only decode states whose hash
+// matches, by applying the deltas to their keyframe.
+class DeltaClosedSet : public ClosedSetItf {
+public:
+    explicit DeltaClosedSet(int keyframe_interval = 8);
+
+    bool contains(const SearchState &state) const override;
+    Handle insert(const SearchState &state, Handle parent) override;
+    size_t size() const override;
+    void clear() override;
+
+    // bytes taken by the encoded states, without the index
+    size_t dataSize() const { return data_.size(); }
+
+private:
+    using Bytes = std::array<std::uint8_t, nb_cards + nb_homes>;
+
+    struct Entry {
+        std::uint64_t hash;
+        std::uint64_t offset;  // into data_, which may outgrow 4 GiB
+        std::uint32_t base;    // entry the delta applies to, no_handle for a keyframe
+        std::uint8_t nb_changes;
+        std::uint8_t chain;    // number of deltas down to the keyframe
+    };
+
+    static Bytes bytes_(const SearchState &state);
+    Bytes decode_(Handle index) const;
+    // slot of the entry holding these bytes, or of the empty slot ending the probe
+    size_t find_(std::uint64_t hash, const Bytes &bytes) const;
+    void grow_();
+
+    int keyframe_interval_;
+    std::vector<Entry> entries_;
+    std::vector<std::uint8_t> data_;    // keyframes, or (position, byte) pairs of deltas
+    std::vector<std::uint32_t> table_;  // entry index + 1, 0 marks an empty slot
+};
+
+// Approximate set, a blocked Bloom filter of 2^log2_bits bits. A state sets
+// one bit in each of the 8 words of a 64-byte block picked by its hash, so
+// a lookup touches a single cache line. It never misses a seen state, but
+// may take a new one for seen, the more likely the fuller it is.
+// size() counts the states which set at least one new bit.
+class ApproxClosedSet : public ClosedSetItf {
+public:
+    explicit ApproxClosedSet(int log2_bits);
+
+    bool contains(const SearchState &state) const override;
+    Handle insert(const SearchState &state, Handle parent) override;
+    size_t size() const override;
+    void clear() override;
+
+    // estimated from the share of bits set
+    double falsePositiveRate() const override;
+
+private:
+    static constexpr int block_words = 8;
+
+    // first of the block words, and the bit within each of them
+    size_t block_(std::uint64_t hash) const;
+    static std::uint64_t bits_(std::uint64_t hash);
+    static std::uint64_t bit_(std::uint64_t bits, int word);
+
+    size_t nb_words_;
+    std::vector<std::uint64_t> words_;  // allocated on the first insert
+    size_t nb_bits_set_;
+    size_t size_;
+};
+
+#endif
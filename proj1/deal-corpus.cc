@@ -0,0 +1,132 @@
+#include "deal-corpus.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+template <typename T>
+static void putLittleEndian(std::uint8_t *out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+}
+
+template <typename T>
+static T getLittleEndian(const std::uint8_t *in) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<T>(in[i]) << (8 * i);
+    return value;
+}
+
+static std::array<std::uint8_t, corpus_header_size> corpusHeader(std::uint64_t nb_deals) {
+    std::array<std::uint8_t, corpus_header_size> header;
+    std::memcpy(header.data(), corpus_magic, sizeof(corpus_magic));
+    putLittleEndian<std::uint32_t>(header.data() + 8, corpus_version);
+    putLittleEndian<std::uint32_t>(header.data() + 12, nb_cards);
+    putLittleEndian<std::uint64_t>(header.data() + 16, nb_deals);
+    return header;
+}
+
+CorpusWriter::CorpusWriter(const std::string &path) :
+        out_(path, std::ios::binary | std::ios::trunc),
+        nb_deals_(0) {
+    if (!out_)
+        throw std::runtime_error("Cannot open corpus file '" + path + "'");
+
+    auto header = corpusHeader(0);
+    out_.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+CorpusWriter::~CorpusWriter() {
+    close();
+}
+
+void CorpusWriter::write(const PackedState &deal) {
+    write(&deal, 1);
+}
+
+void CorpusWriter::write(const PackedState *deals, size_t nb_deals) {
+    static_assert(sizeof(PackedState) == nb_cards, "PackedState must be tightly packed");
+    out_.write(reinterpret_cast<const char *>(deals), nb_deals * sizeof(PackedState));
+    nb_deals_ += nb_deals;
+}
+
+void CorpusWriter::close() {
+    if (!out_.is_open())
+        return;
+
+    auto header = corpusHeader(nb_deals_);
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char *>(header.data()), header.size());
+    out_.close();
+}
+
+CorpusProducer::CorpusProducer(const std::string &path, size_t first_deal) :
+        file_(path),
+        nb_deals_(0),
+        next_(first_deal) {
+    const std::uint8_t *header = file_.data();
+    if (file_.size() < corpus_header_size || std::memcmp(header, corpus_magic, sizeof(corpus_magic)) != 0)
+        throw std::runtime_error("'" + path + "' is not a deal corpus");
+    if (getLittleEndian<std::uint32_t>(header + 8) != corpus_version)
+        throw std::runtime_error("'" + path + "' has an unsupported corpus version");
+    if (getLittleEndian<std::uint32_t>(header + 12) != nb_cards)
+        throw std::runtime_error("'" + path + "' has an unexpected record size");
+
+    nb_deals_ = getLittleEndian<std::uint64_t>(header + 16);
+    if (file_.size() < corpus_header_size + nb_deals_ * sizeof(PackedState))
+        throw std::runtime_error("'" + path + "' is truncated");
+}
+
+size_t CorpusProducer::nbDeals() const {
+    return nb_deals_;
+}
+
+const PackedState& CorpusProducer::deal(size_t i) const {
+    // records are byte arrays, so any alignment will do
+    return *reinterpret_cast<const PackedState *>(file_.data() + corpus_header_size + i * sizeof(PackedState));
+}
+
+GameState CorpusProducer::produce() {
+    if (next_ >= nb_deals_)
+        throw std::out_of_range("Deal corpus exhausted");
+
+    return unpackState(deal(next_++));
+}
+
+// splitmix64 finalizer, spreads consecutive deal indices over unrelated seeds
+static std::uint32_t dealSeed(int seed, std::uint64_t index) {
+    std::uint64_t z = (static_cast<std::uint64_t>(seed) << 32 ^ index) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<std::uint32_t>(z ^ (z >> 31));
+}
+
+std::vector<PackedState> generateEasyDeals(int seed, int difficulty, size_t nb_deals, unsigned nb_threads) {
+    std::vector<PackedState> deals(nb_deals);
+    nb_threads = std::max(1u, nb_threads);
+
+    auto generate_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::default_random_engine rng(dealSeed(seed, i));
+
+            GameState gs;
+            initializeEasyDeal(&gs, rng, difficulty);
+            deals[i] = packState(gs);
+        }
+    };
+
+    // contiguous ranges keep threads from writing into the same cache lines
+    std::vector<std::thread> threads;
+    size_t chunk = (nb_deals + nb_threads - 1) / nb_threads;
+    for (unsigned t = 0; t < nb_threads; ++t) {
+        size_t begin = std::min(nb_deals, t * chunk);
+        size_t end = std::min(nb_deals, begin + chunk);
+        threads.emplace_back(generate_range, begin, end);
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    return deals;
+}
@@ -0,0 +1,60 @@
+#ifndef DEAL_CORPUS_H
+#define DEAL_CORPUS_H
+
+#include "game.h"
+#include "mapped-file.h"
+#include "packed-state.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary deal corpus: a 24-byte header followed by one 52-byte PackedState per deal.
+// Header: magic "FCDEALS" + NUL, then little-endian uint32 version,
+// uint32 record size and uint64 number of deals.
+inline constexpr char corpus_magic[8] = {'F', 'C', 'D', 'E', 'A', 'L', 'S', '\0'};
+inline constexpr std::uint32_t corpus_version = 1;
+inline constexpr size_t corpus_header_size = 24;
+
+class CorpusWriter {
+public:
+    explicit CorpusWriter(const std::string &path);
+    ~CorpusWriter();
+
+    void write(const PackedState &deal);
+    void write(const PackedState *deals, size_t nb_deals);
+
+    // patches the number of deals into the header, called by the destructor too
+    void close();
+
+private:
+    std::ofstream out_;
+    std::uint64_t nb_deals_;
+};
+
+// Yields the deals of a corpus file, mapped into memory, starting from first_deal.
+// Throws std::runtime_error on a malformed file and std::out_of_range when
+// asked for more deals than there are.
+class CorpusProducer : public InitialStateProducerItf {
+public:
+    explicit CorpusProducer(const std::string &path, size_t first_deal = 0);
+    GameState produce() override;
+
+    size_t nbDeals() const;
+    const PackedState& deal(size_t i) const;
+
+private:
+    MappedFile file_;
+    size_t nb_deals_;
+    size_t next_;
+};
+
+// Generates nb_deals easy deals (see initializeEasyDeal) straight into the
+// packed corpus format, spread over nb_threads threads.
+// Deal i comes from its own engine seeded with (seed, i), so the result does
+// not depend on the number of threads; it differs from the deals of
+// EasyProducer(seed, difficulty), which share a single engine.
+std::vector<PackedState> generateEasyDeals(int seed, int difficulty, size_t nb_deals, unsigned nb_threads);
+
+#endif
@@ -1,4 +1,47 @@
 #include "evaluation-type.h"
+#include "search-interface.h"
+
+void recordSearch(DealRecord &record, const SearchStats &stats, const CancellationToken &cancel) {
+    record.nb_expanded = cancel.nbExpanded();
+    record.nb_generated = stats.nb_generated;
+    record.nb_pruned = stats.nb_pruned;
+    record.peak_open = stats.peak_open;
+    record.peak_closed = stats.peak_closed;
+    record.out_of_budget = cancel.cancelled();
+    record.out_of_memory = cancel.outOfMemory();
+    record.nb_closed_hits = stats.nb_closed_hits;
+    record.closed_fp_rate = stats.closed_fp_rate;
+    record.winner = stats.winner;
+}
+
+void addDealRecord(StrategyEvaluation &report, const DealRecord &record) {
+    if (record.solved) {
+        report.nb_solved++;
+        report.total_solution_length += record.solution_length;
+        report.time_taken += record.wall_time;
+    } else {
+        report.nb_failed++;
+        if (record.out_of_memory)
+            report.nb_out_of_memory++;
+        else if (record.out_of_budget)
+            report.nb_out_of_budget++;
+    }
+    report.nb_states_expanded += record.nb_expanded;
+    report.nb_pruned += record.nb_pruned;
+    report.nb_closed_hits += record.nb_closed_hits;
+    report.closed_false_positives += record.nb_closed_hits * record.closed_fp_rate;
+    if (record.solved && !record.winner.empty())
+        report.portfolio_wins[record.winner]++;
+    report.time_histogram.record(record.wall_time.count());
+    report.expanded_histogram.record(record.nb_expanded);
+}
+
+static void printPercentiles(std::ostream& os, const LogHistogram &histogram) {
+    os << "p50 " << histogram.percentile(50) <<
+        " p90 " << histogram.percentile(90) <<
+        " p99 " << histogram.percentile(99) <<
+        " max " << histogram.max();
+}
 
 std::ostream& operator<< (std::ostream& os, const StrategyEvaluation &report) {
     if (report.nb_solved > 0) {
@@ -6,16 +49,52 @@ std::ostream& operator<< (std::ostream& os, const StrategyEvaluation &report) {
             " [ " << 100.0*report.nb_solved / (report.nb_solved + report.nb_failed) << " % ]. " <<
             "Avg solution length " << 1.0 * report.total_solution_length / report.nb_solved << " steps, "
             "Avg time taken: " << (report.time_taken / report.nb_solved).count() << " us " <<
-            "Total #states expaned: " << report.nb_states_expanded << 
+            "Total #states expaned: " << report.nb_states_expanded <<
+            " Out of budget: " << report.nb_out_of_budget <<
+            " Out of memory: " << report.nb_out_of_memory <<
             "\n";
     } else {
         os << "Solved " << report.nb_solved << " / " << report.nb_solved + report.nb_failed <<
             " [ 0 % ]. " <<
             "Avg solution length NA steps, " <<
             "Avg time taken: NA us " <<
-            "Total #states expaned: " << report.nb_states_expanded << 
+            "Total #states expaned: " << report.nb_states_expanded <<
+            " Out of budget: " << report.nb_out_of_budget <<
+            " Out of memory: " << report.nb_out_of_memory <<
             "\n";
     }
 
+    if (report.time_histogram.count() > 0) {
+        os << "Time per deal [us]: ";
+        printPercentiles(os, report.time_histogram);
+        os << ", #states expanded per deal: ";
+        printPercentiles(os, report.expanded_histogram);
+        os << "\n";
+    }
+
+    if (report.nb_pruned > 0)
+        os << "Dead ends pruned: " << report.nb_pruned << "\n";
+
+    if (report.closed_false_positives > 0)
+        os << "Closed set hits: " << report.nb_closed_hits <<
+            ", of them false positives (estimate, at most): " << report.closed_false_positives << "\n";
+
+    if (!report.portfolio_wins.empty()) {
+        os << "Portfolio wins:";
+        for (const auto &[member, nb_wins] : report.portfolio_wins)
+            os << " " << member << " " << nb_wins;
+        os << "\n";
+    }
+
+    if (report.nb_moves_saved > 0)
+        os << "Moves cut by the solution optimizer: " << report.nb_moves_saved << "\n";
+
+    if (report.nb_cache_hits > 0)
+        os << "Solutions replayed from cache: " << report.nb_cache_hits << "\n";
+
+#ifdef SUI_PROFILE
+    os << report.profile;
+#endif
+
     return os;
-} 
+}
@@ -1,18 +1,70 @@
 #ifndef EVALUATION_TYPE_H
 #define EVALUATION_TYPE_H
 
+#include "histogram.h"
+#include "profile.h"
+
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <string>
 
 struct StrategyEvaluation {
-	StrategyEvaluation() : nb_solved(0), nb_failed(0), total_solution_length(0), nb_states_expanded(0), time_taken(0) {}
+	StrategyEvaluation() : nb_solved(0), nb_failed(0), nb_out_of_budget(0), nb_out_of_memory(0), nb_cache_hits(0), nb_pruned(0), nb_closed_hits(0), closed_false_positives(0), nb_moves_saved(0), total_solution_length(0), nb_states_expanded(0), time_taken(0) {}
     unsigned long nb_solved;
     unsigned long nb_failed;
+    unsigned long nb_out_of_budget; // subset of nb_failed, cancelled by time/node limit
+    unsigned long nb_out_of_memory; // subset of nb_failed, given up under memory pressure
+    unsigned long nb_cache_hits; // subset of nb_solved, replayed from a SolutionCache
+    unsigned long long nb_pruned; // generated states dropped as dead ends, over all deals
+    unsigned long long nb_closed_hits; // states dropped as already seen, over all deals
+    double closed_false_positives; // estimated share of nb_closed_hits wrongly taken for seen
+    unsigned long long nb_moves_saved; // by shortening solutions after the search
+    std::map<std::string, unsigned long> portfolio_wins; // deals solved by each member of a portfolio
     unsigned long total_solution_length;
     unsigned long long nb_states_expanded;
     std::chrono::microseconds time_taken;
+
+    // per-deal distributions over all deals, solved or not
+    LogHistogram time_histogram; // in microseconds
+    LogHistogram expanded_histogram;
+
+    // hot-path phases summed over all solves, empty unless built with SUI_PROFILE
+    PhaseProfile profile;
 };
 
+// Outcome of a single deal, as streamed by ResultsWriter
+struct DealRecord {
+    int seed;
+    int index; // position of the deal within the run
+    bool solved;
+    size_t solution_length;
+    std::chrono::microseconds wall_time;
+    unsigned long long nb_expanded;
+    unsigned long long nb_generated;
+    unsigned long long nb_pruned;
+    size_t peak_open;
+    size_t peak_closed;
+    size_t peak_rss;
+
+    // not streamed, only summed up in the report
+    bool out_of_budget;
+    bool out_of_memory;
+    unsigned long long nb_closed_hits;
+    double closed_fp_rate;
+    std::string winner; // portfolio member which solved the deal, if any
+};
+
+struct SearchStats;
+class CancellationToken;
+
+// Fills in what the statistics of the solver and the token of the deal
+// tell about its search.
+void recordSearch(DealRecord &record, const SearchStats &stats, const CancellationToken &cancel) ;
+
+// Adds a finished deal to the totals and distributions of the report.
+void addDealRecord(StrategyEvaluation &report, const DealRecord &record) ;
+
 std::ostream& operator<< (std::ostream& os, const StrategyEvaluation &report) ;
 
 #endif
@@ -1,100 +1,536 @@
 #include "move.h"
 #include "game.h"
+#include "deal-corpus.h"
 #include "search-interface.h"
 #include "search-strategies.h"
+#include "solver-factory.h"
 
 #include "evaluation-type.h"
 #include "argparse.h"
 #include "mem_watch.h"
+#include "memusage.h"
+#include "results-stream.h"
+#include "solution-cache.h"
+#include "solution-stream.h"
+#include "replay-board.h"
+#include "solver-server.h"
+#include "solution-optimizer.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <type_traits>
+#include <variant>
+#include <csignal>
 
 #include <thread>
 #include <atomic>
 
 
-void eval_strategy(
+DealRecord eval_strategy(
         std::unique_ptr<SearchStrategyItf> &search_strategy,
         const SearchState &init_state,
-        StrategyEvaluation *report
+        CancellationToken &cancel,
+        SolutionCache *cache,
+        int optimize_window,  // negative to keep solutions as found
+        StrategyEvaluation *report,
+        std::vector<SearchAction> *solution_out = nullptr
     ) {
 
+#ifdef SUI_PROFILE
+    threadProfile() = {};
+#endif
+
     auto t0 = std::chrono::steady_clock::now();
-	auto solution = search_strategy->solve(init_state);
+
+    // a cached solution is only trusted once it has been replayed successfully
+    std::optional<std::vector<SearchAction>> cached;
+    if (cache)
+        cached = cache->find(init_state);
+    bool from_cache = cached.has_value() && replaySolves(init_state, *cached);
+
+	auto solution = from_cache ? *cached : search_strategy->solve(init_state, cancel);
+    if (!from_cache && optimize_window >= 0 && !solution.empty()) {
+        auto found_length = solution.size();
+        solution = shortenSolution(init_state, solution, optimize_window);
+        report->nb_moves_saved += found_length - solution.size();
+    }
     auto t1 = std::chrono::steady_clock::now();
 
+#ifdef SUI_PROFILE
+    report->profile += threadProfile();
+#endif
 
-	SearchState in_progress(init_state);
-	for (const auto & action : solution)
-		in_progress = action.execute(in_progress);
+    DealRecord record{};
+    record.solved = from_cache || replaySolves(init_state, solution);
+    record.solution_length = solution.size();
+    record.wall_time = std::chrono::duration_cast<decltype(record.wall_time)>(t1 - t0);
+    if (!from_cache)
+        recordSearch(record, search_strategy->stats(), cancel);
 
-    if (in_progress.isFinal()) {
-        report->nb_solved++;
-        report->total_solution_length += solution.size();
-        report->time_taken += std::chrono::duration_cast<decltype(report->time_taken)>(t1 - t0);
-    } else {
-        report->nb_failed++;
-    }
-    report->nb_states_expanded = SearchState::nbExpanded();
+    if (from_cache)
+        report->nb_cache_hits++;
+    else if (record.solved && cache)
+        cache->store(init_state, solution);
+    addDealRecord(*report, record);
+
+    if (solution_out)
+        *solution_out = std::move(solution);
+
+    return record;
 }
 
 std::unique_ptr<InitialStateProducerItf> getProducer(const argparse::ArgumentParser &parser) {
     auto difficulty = parser.get<int>("--easy-mode");
     auto seed = parser.get<int>("seed");
+    auto corpus_path = parser.get<std::string>("--corpus");
 
-    if (difficulty < 0) {
+    if (!corpus_path.empty()) {
+        // the seed selects the first deal of the corpus
+        try {
+            return std::make_unique<CorpusProducer>(corpus_path, std::max(seed, 0));
+        } catch (const std::runtime_error &err) {
+            std::cerr << err.what() << "\n";
+            std::exit(2);
+        }
+    } else if (parser.get<bool>("--ms-deals")) {
+        // the seed is the number of the first deal
+        return std::make_unique<MsDealProducer>(seed);
+    } else if (difficulty < 0) {
         return std::make_unique<RandomProducer>(seed);
     } else {
         return std::make_unique<EasyProducer>(seed, difficulty);
     }
 }
 
-std::unique_ptr<AStarHeuristicItf> getHeuristic(const argparse::ArgumentParser &parser) {
-    auto heuristic_name = parser.get<std::string>("--heuristic");
+// every option of solverOptions() as --name, with the default of SolverConfig{}
+void addSolverArguments(argparse::ArgumentParser &parser) {
+    const SolverConfig defaults;
+    for (const auto &option : solverOptions()) {
+        auto &argument = parser.add_argument(std::string("--") + option.name);
+        std::visit([&](auto field) {
+            using T = std::decay_t<decltype(defaults.*field)>;
+            argument.default_value(defaults.*field);
+            if constexpr (std::is_same_v<T, int>)
+                argument.scan<'d', int>();
+            else if constexpr (std::is_same_v<T, double>)
+                argument.scan<'g', double>();
+            else if constexpr (!std::is_same_v<T, std::string>)
+                argument.scan<'u', T>();
+        }, option.field);
+    }
+}
+
+SolverConfig configFromParser(const argparse::ArgumentParser &parser) {
+    SolverConfig config;
+    for (const auto &option : solverOptions()) {
+        std::visit([&](auto field) {
+            using T = std::decay_t<decltype(config.*field)>;
+            config.*field = parser.get<T>(std::string("--") + option.name);
+        }, option.field);
+    }
+    return config;
+}
+
+std::unique_ptr<SearchStrategyItf> getSolver(const SolverConfig &config) {
+    try {
+        return makeSolver(config);
+    } catch (const std::invalid_argument &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+}
 
-    if (heuristic_name == "nb_not_home") {
-        return std::make_unique<OufOfHome_Pseudo>();
-    } else if (heuristic_name == "student") {
-	    return std::make_unique<StudentHeuristic>();
+void dumpDeals(const argparse::ArgumentParser &parser, InitialStateProducerItf &producer, int nb_games, const std::string &path) {
+    auto batch_threads = parser.get<unsigned>("--batch-threads");
+    auto difficulty = parser.get<int>("--easy-mode");
+    bool batch = batch_threads > 0 && difficulty >= 0 &&
+        !parser.get<bool>("--ms-deals") && parser.get<std::string>("--corpus").empty();
+
+    try {
+        CorpusWriter writer(path);
+        if (batch) {
+            auto deals = generateEasyDeals(parser.get<int>("seed"), difficulty, nb_games, batch_threads);
+            writer.write(deals.data(), deals.size());
+        } else {
+            for (int i = 0; i < nb_games; ++i)
+                writer.write(packState(producer.produce()));
+        }
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+}
+
+std::unique_ptr<SolutionCache> getSolutionCache(const argparse::ArgumentParser &parser) {
+    auto path = parser.get<std::string>("--solution-cache");
+    if (path.empty())
+        return nullptr;
+
+    try {
+        return std::make_unique<SolutionCache>(path);
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+}
+
+std::unique_ptr<SolutionWriter> getSolutionWriter(const argparse::ArgumentParser &parser) {
+    auto path = parser.get<std::string>("--save-solutions");
+    if (path.empty())
+        return nullptr;
+
+    auto format_name = parser.get<std::string>("--solutions-format");
+    SolutionWriter::Format format;
+    if (format_name == "text") {
+        format = SolutionWriter::Format::Text;
+    } else if (format_name == "binary") {
+        format = SolutionWriter::Format::Binary;
     } else {
-        std::cerr << "Unknown heuristic name '" << heuristic_name << "'\n";
-        std::cerr << "Supported are: nb_not_home, student\n";
+        std::cerr << "Unknown solutions format '" << format_name << "'\n";
+        std::cerr << "Supported are: text, binary\n";
+        std::exit(2);
+    }
+
+    try {
+        return std::make_unique<SolutionWriter>(path, format);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
         std::exit(2);
     }
 }
 
-std::unique_ptr<SearchStrategyItf> getSolver(const argparse::ArgumentParser &parser) {
-    auto solver_name = parser.get<std::string>("--solver");
-
-    if (solver_name == "dummy") {
-        return std::make_unique<DummySearch>(500, 5);
-    } else if (solver_name == "bfs") {
-	    return std::make_unique<BreadthFirstSearch>(parser.get<size_t>("--mem-limit"));
-    } else if (solver_name == "dfs") {
-        return std::make_unique<DepthFirstSearch>(parser.get<int>("--dls-limit"), parser.get<size_t>("--mem-limit"));
-    } else if (solver_name == "a_star") {
-        return std::make_unique<AStarSearch>(getHeuristic(parser), parser.get<size_t>("--mem-limit"));
+// Replays saved solutions on the deals they were saved for, which the producer
+// has to reproduce (same deal source and seed as the run that saved them).
+// Returns the exit code, non-zero if any solution does not solve its deal.
+int replaySolutions(InitialStateProducerItf &producer, const std::string &path) {
+    std::vector<DealSolution> solutions;
+    try {
+        solutions = readSolutions(path);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+
+    std::sort(solutions.begin(), solutions.end(), [](const auto &a, const auto &b) { return a.index < b.index; });
+
+    unsigned long next_index = 0;
+    std::optional<GameState> gs;
+    size_t nb_valid = 0;
+    for (const auto &solution : solutions) {
+        try {
+            while (next_index <= solution.index) {
+                gs.emplace(producer.produce());
+                next_index++;
+            }
+        } catch (const std::out_of_range &err) {
+            std::cerr << err.what() << " before deal " << solution.index << "\n";
+            break;
+        }
+
+        if (replaySolves(*gs, solution.moves))
+            nb_valid++;
+        else
+            std::cerr << "Solution of deal " << solution.index << " does not solve it\n";
+    }
+
+    std::cout << "Verified " << nb_valid << " / " << solutions.size() << " solutions\n";
+    return nb_valid == solutions.size() ? 0 : 1;
+}
+
+std::unique_ptr<ResultsWriter> getResultsWriter(const argparse::ArgumentParser &parser) {
+    auto path = parser.get<std::string>("--results");
+    if (path.empty())
+        return nullptr;
+
+    auto format_name = parser.get<std::string>("--results-format");
+    ResultsWriter::Format format;
+    if (format_name == "jsonl") {
+        format = ResultsWriter::Format::Jsonl;
+    } else if (format_name == "csv") {
+        format = ResultsWriter::Format::Csv;
     } else {
-        std::cerr << "Unknown solver name '" << solver_name << "'\n";
-        std::cerr << "Supported are: dummy, bfs, a_star, dfs\n";
+        std::cerr << "Unknown results format '" << format_name << "'\n";
+        std::cerr << "Supported are: jsonl, csv\n";
         std::exit(2);
     }
+
+    try {
+        return std::make_unique<ResultsWriter>(path, format);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+}
+
+struct VerifyResult {
+    enum class Status {Valid, IllegalMove, NotSolved, NoDeal, BadDeal};
+
+    Status status;
+    size_t nb_applied;  // moves played before the illegal one or the end
+};
+
+// Replays every solution on its corpus deal, in place and spread over
+// nb_threads threads. Solution i is checked against deal first_deal + its index;
+// final boards are kept only if requested.
+std::vector<VerifyResult> verifySolutions(
+        const CorpusProducer &corpus,
+        size_t first_deal,
+        const std::vector<DealSolution> &solutions,
+        unsigned nb_threads,
+        std::vector<std::optional<ReplayBoard>> *final_boards
+    ) {
+    std::vector<VerifyResult> results(solutions.size());
+    if (final_boards)
+        final_boards->assign(solutions.size(), std::nullopt);
+
+    auto verify_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t deal = first_deal + solutions[i].index;
+            if (deal >= corpus.nbDeals()) {
+                results[i] = {VerifyResult::Status::NoDeal, 0};
+                continue;
+            }
+
+            std::optional<ReplayBoard> opt_board;
+            try {
+                opt_board.emplace(corpus.deal(deal));
+            } catch (const std::invalid_argument &) {
+                results[i] = {VerifyResult::Status::BadDeal, 0};
+                continue;
+            }
+
+            ReplayBoard &board = *opt_board;
+            size_t nb_applied = 0;
+            for (auto move : solutions[i].moves) {
+                if (!board.apply(move))
+                    break;
+                nb_applied++;
+            }
+
+            if (nb_applied < solutions[i].moves.size())
+                results[i] = {VerifyResult::Status::IllegalMove, nb_applied};
+            else if (!board.isFinal())
+                results[i] = {VerifyResult::Status::NotSolved, nb_applied};
+            else
+                results[i] = {VerifyResult::Status::Valid, nb_applied};
+
+            if (final_boards)
+                (*final_boards)[i].emplace(board);
+        }
+    };
+
+    nb_threads = std::max(1u, std::min<unsigned>(nb_threads, solutions.size()));
+    size_t chunk = (solutions.size() + nb_threads - 1) / nb_threads;
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nb_threads; ++t)
+        threads.emplace_back(verify_range, std::min(t * chunk, solutions.size()), std::min((t + 1) * chunk, solutions.size()));
+    verify_range(0, std::min(chunk, solutions.size()));
+
+    for (auto &thread : threads)
+        thread.join();
+
+    return results;
 }
 
+// fc-sui verify CORPUS SOLUTIONS: audits saved solutions against a deal corpus
+int verifyMain(int argc, const char *argv[]) {
+    argparse::ArgumentParser parser("fc-sui verify");
+    parser.add_argument("corpus");
+    parser.add_argument("solutions");
+    parser.add_argument("--first-deal").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--threads").default_value(0u).scan<'u', unsigned>();
+    parser.add_argument("--print-final").default_value(false).implicit_value(true);
+
+    try {
+        parser.parse_args(argc - 1, argv + 1);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::cerr << parser;
+        std::exit(2);
+    }
+
+    std::optional<CorpusProducer> corpus;
+    std::vector<DealSolution> solutions;
+    try {
+        corpus.emplace(parser.get<std::string>("corpus"));
+        solutions = readSolutions(parser.get<std::string>("solutions"));
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+
+    auto nb_threads = parser.get<unsigned>("--threads");
+    if (nb_threads == 0)
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool print_final = parser.get<bool>("--print-final");
+
+    std::vector<std::optional<ReplayBoard>> final_boards;
+    auto t0 = std::chrono::steady_clock::now();
+    auto results = verifySolutions(*corpus, parser.get<size_t>("--first-deal"), solutions, nb_threads, print_final ? &final_boards : nullptr);
+    auto t1 = std::chrono::steady_clock::now();
+
+    size_t nb_valid = 0;
+    size_t nb_moves = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::cout << solutions[i].index << " ";
+        switch (results[i].status) {
+            case VerifyResult::Status::Valid:
+                nb_valid++;
+                std::cout << "valid " << results[i].nb_applied << " moves\n";
+                break;
+            case VerifyResult::Status::IllegalMove:
+                std::cout << "illegal move " << results[i].nb_applied + 1 << " ("
+                    << moveText(solutions[i].moves[results[i].nb_applied]) << ")\n";
+                break;
+            case VerifyResult::Status::NotSolved:
+                std::cout << "not solved after " << results[i].nb_applied << " moves\n";
+                break;
+            case VerifyResult::Status::NoDeal:
+                std::cout << "no such deal in the corpus\n";
+                break;
+            case VerifyResult::Status::BadDeal:
+                std::cout << "malformed deal in the corpus\n";
+                break;
+        }
+        nb_moves += results[i].nb_applied;
+
+        if (print_final && final_boards[i].has_value())
+            std::cout << final_boards[i]->gameState();
+    }
+
+    auto elapsed = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "Verified " << nb_valid << " / " << solutions.size() << " solutions, "
+        << nb_moves << " moves in " << elapsed * 1000 << " ms";
+    if (elapsed > 0)
+        std::cout << " (" << nb_moves / elapsed << " moves/s)";
+    std::cout << "\n";
+
+    return nb_valid == solutions.size() ? 0 : 1;
+}
+
+SolverServer *running_server = nullptr;
+
+void stopServer(int) {
+    if (running_server)
+        running_server->stop();
+}
+
+// fc-sui serve SOCKET: solves deals sent over a Unix domain socket until interrupted
+int serveMain(int argc, const char *argv[]) {
+    argparse::ArgumentParser parser("fc-sui serve");
+    parser.add_argument("socket");
+    parser.add_argument("--workers").default_value(0u).scan<'u', unsigned>();
+    parser.add_argument("--queue-size").default_value(std::size_t{1024}).scan<'u', size_t>();
+    parser.add_argument("--max-solver-threads").default_value(0u).scan<'u', unsigned>();
+    parser.add_argument("--max-mcts-nodes").default_value(std::size_t{1} << 22).scan<'u', size_t>();
+    parser.add_argument("--max-tt-size").default_value(std::size_t{1} << 24).scan<'u', size_t>();
+    parser.add_argument("--max-approx-closed-bits").default_value(32).scan<'d', int>();
+    parser.add_argument("--max-expand-batch").default_value(std::size_t{1024}).scan<'u', size_t>();
+    parser.add_argument("--max-difficulty").default_value(1000).scan<'d', int>();
+    parser.add_argument("--max-request-length").default_value(std::size_t{64 * 1024}).scan<'u', size_t>();
+    addSolverArguments(parser);
+    parser.add_argument("--mem-limit").default_value(std::size_t{2'147'483'648}).scan<'u', size_t>();
+    parser.add_argument("--mem-soft-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--time-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--node-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+
+    try {
+        parser.parse_args(argc - 1, argv + 1);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::cerr << parser;
+        std::exit(2);
+    }
+
+    ServerOptions options;
+    options.nb_workers = parser.get<unsigned>("--workers");
+    if (options.nb_workers == 0)
+        options.nb_workers = std::max(1u, std::thread::hardware_concurrency());
+    options.queue_capacity = std::max<size_t>(1, parser.get<size_t>("--queue-size"));
+    options.max_solver_threads = parser.get<unsigned>("--max-solver-threads");
+    if (options.max_solver_threads == 0)
+        options.max_solver_threads = std::max(1u, std::thread::hardware_concurrency());
+    options.max_mcts_nodes = parser.get<size_t>("--max-mcts-nodes");
+    options.max_tt_size = parser.get<size_t>("--max-tt-size");
+    options.max_approx_closed_bits = parser.get<int>("--max-approx-closed-bits");
+    options.max_expand_batch = std::max<size_t>(1, parser.get<size_t>("--max-expand-batch"));
+    options.max_difficulty = parser.get<int>("--max-difficulty");
+    options.max_request_length = parser.get<size_t>("--max-request-length");
+    options.config = configFromParser(parser);
+    options.time_limit = std::chrono::milliseconds(parser.get<size_t>("--time-limit"));
+    options.node_limit = parser.get<size_t>("--node-limit");
+
+    getSolver(options.config);  // exits on a bad configuration
+
+    StrategyEvaluation evaluation_record;
+
+    auto mem_limit = parser.get<size_t>("--mem-limit");
+    auto mem_soft_limit = parser.get<size_t>("--mem-soft-limit");
+    if (mem_soft_limit == 0)
+        mem_soft_limit = mem_limit / 10 * 9;
+
+    MemWatcher mem_watcher(
+        mem_soft_limit,
+        mem_limit,
+        std::chrono::milliseconds(100),
+        evaluation_record
+    );
+    std::thread thread_mem_watch(&MemWatcher::run, &mem_watcher);
+
+    std::optional<SolverServer> server;
+    try {
+        server.emplace(parser.get<std::string>("socket"), options, &mem_watcher, evaluation_record);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << "\n";
+        std::exit(2);
+    }
+
+    running_server = &*server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    server->run();
+    running_server = nullptr;
+
+    mem_watcher.kill();
+    thread_mem_watch.join();
+
+    std::cout << evaluation_record;
+    return 0;
+}
 
 int main(int argc, const char *argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "verify")
+        return verifyMain(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "serve")
+        return serveMain(argc, argv);
+
     argparse::ArgumentParser parser("FreeCell@SUI");
     parser.add_argument("nb_games").scan<'d', int>();
     parser.add_argument("seed").scan<'d', int>();
 
     parser.add_argument("--easy-mode").default_value(-1).scan<'d', int>();
-    parser.add_argument("--solver").default_value(std::string("dummy"));
-    parser.add_argument("--heuristic").default_value(std::string("nb_not_home"));
-    parser.add_argument("--dls-limit").default_value(1'000'000).scan<'d', int>();
+    addSolverArguments(parser);
     parser.add_argument("--mem-limit").default_value(std::size_t{2'147'483'648}).scan<'u', size_t>();
+    parser.add_argument("--mem-soft-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--time-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--node-limit").default_value(std::size_t{0}).scan<'u', size_t>();
+    parser.add_argument("--ms-deals").default_value(false).implicit_value(true);
+    parser.add_argument("--corpus").default_value(std::string(""));
+    parser.add_argument("--dump-deals").default_value(std::string(""));
+    parser.add_argument("--batch-threads").default_value(0u).scan<'u', unsigned>();
+    parser.add_argument("--solution-cache").default_value(std::string(""));
+    parser.add_argument("--optimize-solutions").default_value(false).implicit_value(true);
+    parser.add_argument("--optimize-window").default_value(2).scan<'d', int>();
+    parser.add_argument("--save-solutions").default_value(std::string(""));
+    parser.add_argument("--solutions-format").default_value(std::string("text"));
+    parser.add_argument("--replay-solutions").default_value(std::string(""));
+    parser.add_argument("--results").default_value(std::string(""));
+    parser.add_argument("--results-format").default_value(std::string("jsonl"));
 
     try {
         parser.parse_args(argc, argv);
@@ -104,23 +540,70 @@ int main(int argc, const char *argv[]) {
         std::exit(2);
     }
 
+    std::unique_ptr<InitialStateProducerItf> producer = getProducer(parser);
+    auto nb_games = parser.get<int>("nb_games");
+
+    auto dump_path = parser.get<std::string>("--dump-deals");
+    if (!dump_path.empty()) {
+        dumpDeals(parser, *producer, nb_games, dump_path);
+        return 0;
+    }
+
+    auto replay_path = parser.get<std::string>("--replay-solutions");
+    if (!replay_path.empty())
+        return replaySolutions(*producer, replay_path);
+
     StrategyEvaluation evaluation_record;
 
+    auto mem_limit = parser.get<size_t>("--mem-limit");
+    auto mem_soft_limit = parser.get<size_t>("--mem-soft-limit");
+    if (mem_soft_limit == 0)
+        mem_soft_limit = mem_limit / 10 * 9;
+
     MemWatcher mem_watcher(
-        parser.get<size_t>("--mem-limit"),
-        std::chrono::milliseconds(1000),
+        mem_soft_limit,
+        mem_limit,
+        std::chrono::milliseconds(100),
         evaluation_record
     );
     std::thread thread_mem_watch(&MemWatcher::run, &mem_watcher);
 
-    std::unique_ptr<InitialStateProducerItf> producer = getProducer(parser);
-    std::unique_ptr<SearchStrategyItf> search_strategy = getSolver(parser);
+    std::unique_ptr<SearchStrategyItf> search_strategy = getSolver(configFromParser(parser));
+    std::unique_ptr<ResultsWriter> results_writer = getResultsWriter(parser);
+    std::unique_ptr<SolutionCache> solution_cache = getSolutionCache(parser);
+    std::unique_ptr<SolutionWriter> solution_writer = getSolutionWriter(parser);
+
+    auto time_limit = std::chrono::milliseconds(parser.get<size_t>("--time-limit"));
+    auto node_limit = parser.get<size_t>("--node-limit");
+    auto optimize_window = parser.get<bool>("--optimize-solutions") ? parser.get<int>("--optimize-window") : -1;
 
-    auto nb_games = parser.get<int>("nb_games");
     for (int i = 0; i < nb_games; ++i) {
-        GameState gs = producer->produce();
-        SearchState init_state(gs);
-        eval_strategy(search_strategy, init_state, &evaluation_record);
+        std::optional<GameState> gs;
+        try {
+            gs.emplace(producer->produce());
+        } catch (const std::out_of_range &err) {
+            std::cerr << err.what() << " after " << i << " deals\n";
+            break;
+        }
+
+        SearchState init_state(*gs);
+        CancellationToken cancel(time_limit, node_limit, &mem_watcher);
+
+        mem_watcher.resetPeakRSS();
+        std::vector<SearchAction> solution;
+        auto record = eval_strategy(search_strategy, init_state, cancel, solution_cache.get(), optimize_window, &evaluation_record, &solution);
+        if (mem_watcher.underPressure())
+            mem_watcher.releaseFreedMemory();
+
+        if (solution_writer && record.solved)
+            solution_writer->write(i, solution);
+
+        if (results_writer) {
+            record.seed = parser.get<int>("seed");
+            record.index = i;
+            record.peak_rss = std::max(mem_watcher.peakRSS(), getCurrentRSS());
+            results_writer->write(record);
+        }
     }
 
     mem_watcher.kill();
@@ -0,0 +1,103 @@
+#include "fingerprint-set.h"
+
+#include <utility>
+
+FingerprintSet::FingerprintSet(size_t initial_capacity) : size_(0) {
+    size_t capacity = 16;
+    while (capacity < initial_capacity)
+        capacity *= 2;
+    slots_.assign(capacity, 0);
+}
+
+size_t FingerprintSet::slot_(std::uint64_t key) const {
+    size_t mask = slots_.size() - 1;
+    // the high bits are mixed in, the low ones of a hash may be weak
+    size_t i = (key ^ (key >> 32)) & mask;
+    while (slots_[i] != 0 && slots_[i] != key)
+        i = (i + 1) & mask;
+    return i;
+}
+
+bool FingerprintSet::insert(std::uint64_t fingerprint) {
+    std::uint64_t key = key_(fingerprint);
+    size_t i = slot_(key);
+    if (slots_[i] == key)
+        return false;
+
+    slots_[i] = key;
+    if (++size_ * 2 > slots_.size())
+        grow_();
+    return true;
+}
+
+bool FingerprintSet::contains(std::uint64_t fingerprint) const {
+    std::uint64_t key = key_(fingerprint);
+    return slots_[slot_(key)] == key;
+}
+
+void FingerprintSet::clear() {
+    std::vector<std::uint64_t>(16, 0).swap(slots_);  // gives the memory back
+    size_ = 0;
+}
+
+void FingerprintSet::grow_() {
+    std::vector<std::uint64_t> old(slots_.size() * 2, 0);
+    std::swap(old, slots_);
+    for (std::uint64_t key : old)
+        if (key != 0)
+            slots_[slot_(key)] = key;
+}
+
+ConcurrentFingerprintSet::ConcurrentFingerprintSet(size_t memory_budget) :
+    capacity_(16),
+    size_(0)
+{
+    while (capacity_ * 2 * sizeof(std::uint64_t) <= memory_budget)
+        capacity_ *= 2;
+    max_size_ = capacity_ / 4 * 3;
+
+    slots_.reset(new std::atomic<std::uint64_t>[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i)
+        slots_[i].store(0, std::memory_order_relaxed);
+}
+
+ConcurrentFingerprintSet::Insert ConcurrentFingerprintSet::insert(std::uint64_t fingerprint) {
+    std::uint64_t key = key_(fingerprint);
+    size_t mask = capacity_ - 1;
+
+    for (size_t i = start_(key); ; i = (i + 1) & mask) {
+        std::uint64_t current = slots_[i].load(std::memory_order_acquire);
+        if (current == key)
+            return Insert::Present;
+        if (current != 0)
+            continue;
+
+        // the slot is only taken when there is room left, the count is
+        // reserved first so that concurrent inserts can not overshoot it
+        if (size_.fetch_add(1, std::memory_order_relaxed) >= max_size_) {
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            return contains(key) ? Insert::Present : Insert::Full;
+        }
+
+        if (slots_[i].compare_exchange_strong(current, key, std::memory_order_acq_rel))
+            return Insert::Added;
+
+        // another thread took the slot in between, maybe with this very key
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        if (current == key)
+            return Insert::Present;
+    }
+}
+
+bool ConcurrentFingerprintSet::contains(std::uint64_t fingerprint) const {
+    std::uint64_t key = key_(fingerprint);
+    size_t mask = capacity_ - 1;
+
+    for (size_t i = start_(key); ; i = (i + 1) & mask) {
+        std::uint64_t current = slots_[i].load(std::memory_order_acquire);
+        if (current == key)
+            return true;
+        if (current == 0)
+            return false;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef FINGERPRINT_SET_H
+#define FINGERPRINT_SET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Set of 64-bit state fingerprints (hashes), an open addressing table with
+// linear probing, 8 bytes per slot. It grows twice as large once half full.
+// Two states with the same fingerprint are taken for the same one; with
+// 64-bit hashes, that is unlikely to matter for any feasible search.
+class FingerprintSet {
+public:
+    explicit FingerprintSet(size_t initial_capacity = 1024);
+
+    // returns false if the fingerprint was already there
+    bool insert(std::uint64_t fingerprint);
+    bool contains(std::uint64_t fingerprint) const;
+
+    size_t size() const { return size_; }
+    void clear();
+
+private:
+    // 0 marks an empty slot, so fingerprint 0 is stored as this one instead
+    static constexpr std::uint64_t zero_substitute = 0x9e3779b97f4a7c15ull;
+
+    static std::uint64_t key_(std::uint64_t fingerprint) {
+        return fingerprint != 0 ? fingerprint : zero_substitute;
+    }
+    size_t slot_(std::uint64_t key) const;
+    void grow_();
+
+    std::vector<std::uint64_t> slots_;
+    size_t size_;
+};
+
+// The same for many threads at once: a lock-free table whose slots are
+// claimed by compare-and-swap. It does not grow; its capacity is the
+// largest power of two of slots fitting into memory_budget bytes, and it
+// refuses new fingerprints once three quarters full, to keep probes short.
+class ConcurrentFingerprintSet {
+public:
+    enum class Insert {Added, Present, Full};
+
+    explicit ConcurrentFingerprintSet(size_t memory_budget);
+
+    Insert insert(std::uint64_t fingerprint);
+    bool contains(std::uint64_t fingerprint) const;
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr std::uint64_t zero_substitute = 0x9e3779b97f4a7c15ull;
+
+    static std::uint64_t key_(std::uint64_t fingerprint) {
+        return fingerprint != 0 ? fingerprint : zero_substitute;
+    }
+    size_t start_(std::uint64_t key) const { return (key ^ (key >> 32)) & (capacity_ - 1); }
+
+    size_t capacity_;
+    size_t max_size_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slots_;
+    std::atomic<size_t> size_;
+};
+
+#endif
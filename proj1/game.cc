@@ -7,15 +7,6 @@
 
 #include <tuple>
 
-template <typename In>
-std::vector<CardStorage *> collect_location_pointers(In begin, In end) {
-    std::vector<CardStorage *> adresses;
-    for (auto it=begin; it != end; ++it)
-        adresses.push_back(it);
-
-    return adresses;
-}
-
 GameState::GameState(void) {
     recalculatePointerArrays_();
 }
@@ -80,25 +71,25 @@ std::vector<Card> topCards(const GameState &gs) {
     return cards;
 }
 
+// rng is deliberately taken by value: every call replays the same random stream,
+// which the deals produced for a given seed depend on
 int moveCardsFromHomes(GameState *gs, int max_nb_cards, size_t stack_begin, size_t stack_end, std::default_random_engine rng) {
     int nb_cards_moved = 0;
     for (; nb_cards_moved < max_nb_cards; ++nb_cards_moved) {
-        std::vector<CardStorage *> considered_froms{&gs->homes[nb_cards_moved % gs->homes.size()]};
-        std::vector<CardStorage *> considered_tos = collect_location_pointers(gs->stacks.begin() + stack_begin, gs->stacks.begin() + stack_end);
+        CardStorage *from = &gs->homes[nb_cards_moved % gs->homes.size()];
 
-        auto moves = availableMoves(
-            considered_froms.begin(),
-            considered_froms.end(),
-            considered_tos.begin(),
-            considered_tos.end()
-        );
+        std::array<CardStorage *, nb_stacks> considered_tos;
+        size_t nb_tos = 0;
+        for (size_t i = stack_begin; i < stack_end; ++i) {
+            if (moveLegal(from, &gs->stacks[i]))
+                considered_tos[nb_tos++] = &gs->stacks[i];
+        }
 
-        if (moves.size() == 0)
+        if (nb_tos == 0)
             break;
 
-        int pick = std::uniform_int_distribution<std::mt19937::result_type>(0, moves.size()-1)(rng);
-        // we have a non-const access to GameState (gs), so we are allowed to de-const the pointers in RawMove
-        move(const_cast<CardStorage *>(moves[pick].first), const_cast<CardStorage *>(moves[pick].second));
+        int pick = std::uniform_int_distribution<std::mt19937::result_type>(0, nb_tos-1)(rng);
+        move(from, considered_tos[pick]);
     }
 
     return nb_cards_moved;
@@ -129,6 +120,40 @@ void initializeFullRandom(GameState *gs, std::default_random_engine &rng) {
 	assert(card_id_it == order.end());
 }
 
+// Linear congruential generator of the Microsoft C runtime rand()
+class MsRand {
+public:
+    explicit MsRand(std::uint32_t seed) : state_(seed) {}
+
+    std::uint32_t operator()() {
+        state_ = (state_ * 214013u + 2531011u) & 0x7fffffffu;
+        return state_ >> 16;
+    }
+
+private:
+    std::uint32_t state_;
+};
+
+void initializeMsDeal(GameState *gs, std::uint32_t deal_number) {
+    // card c of the original deck is rank c/4 in suit c%4, suits ordered clubs, diamonds, hearts, spades
+    static const std::array<Color, 4> ms_suits{Color::Club, Color::Diamond, Color::Heart, Color::Spade};
+
+    std::array<int, 52> deck;
+    for (int i = 0; i < 52; ++i)
+        deck[i] = 51 - i;
+
+    MsRand rand(deal_number);
+    for (int i = 0; i < 51; ++i) {
+        int j = 51 - rand() % (52 - i);
+        std::swap(deck[i], deck[j]);
+    }
+
+    // dealt row by row, left to right
+    assert(gs->stacks.size() == 8);
+    for (int i = 0; i < 52; ++i)
+        gs->stacks[i % 8].forceCard({ms_suits[deck[i] % 4], deck[i] / 4 + 1});
+}
+
 void forceMove(CardStorage *from, WorkStack *to) {
     to->forceCard(*from->getCard());
 }
@@ -192,38 +217,34 @@ void initializeGameState(GameState *gs, std::default_random_engine &rng) {
 }
 
 std::optional<std::pair<CardStorage *, WorkStack *>> findIrreversibleMove(GameState *gs, std::default_random_engine &rng) {
-    // number of cards that cannot be moved from the given stack 
-    // as it is irreversibely placed in its location
-    std::vector<size_t> frozen_level(gs->stacks.size(), 0);
-
-    std::vector<CardStorage *> possible_from;
+    std::array<CardStorage *, nb_freecells + nb_stacks> possible_from;
+    size_t nb_from = 0;
     for (auto &fc : gs->free_cells) {
         if (fc.topCard().has_value())
-            possible_from.push_back(&fc);
+            possible_from[nb_from++] = &fc;
     }
-    for (size_t i=0; i < gs->stacks.size(); ++i) {
-        auto &stack = gs->stacks[i];
-        if (stack.topCard().has_value() && stack.nbCards() > frozen_level[i])
-            possible_from.push_back(&stack);
+    for (auto &stack : gs->stacks) {
+        if (stack.nbCards() > 0)
+            possible_from[nb_from++] = &stack;
     }
-    if (possible_from.size() == 0)
+    if (nb_from == 0)
         return std::nullopt;
 
-    int pick_from = std::uniform_int_distribution<std::mt19937::result_type>(0, possible_from.size()-1)(rng);
+    int pick_from = std::uniform_int_distribution<std::mt19937::result_type>(0, nb_from-1)(rng);
     auto from = possible_from[pick_from];
 
-    std::vector<WorkStack *> possible_to;
-    for (size_t i=0; i < gs->stacks.size(); ++i) {
-        auto &stack = gs->stacks[i];
+    std::array<WorkStack *, nb_stacks> possible_to;
+    size_t nb_to = 0;
+    for (auto &stack : gs->stacks) {
         bool move_elsewhere = &stack != from;
-        bool stack_not_overfull =stack.nbCards() <= 7;
+        bool stack_not_overfull = stack.nbCards() <= 7;
         if (move_elsewhere && stack_not_overfull)
-            possible_to.push_back(&stack);
+            possible_to[nb_to++] = &stack;
     }
-    if (possible_to.size() == 0)
+    if (nb_to == 0)
         return std::nullopt;
 
-    int pick_to = std::uniform_int_distribution<std::mt19937::result_type>(0, possible_to.size()-1)(rng);
+    int pick_to = std::uniform_int_distribution<std::mt19937::result_type>(0, nb_to-1)(rng);
     auto to = possible_to[pick_to];
 
     return std::make_pair(from, to);
@@ -257,12 +278,12 @@ bool cardCouldGoHome(const GameState &gs, Card card) {
     if (card.value == 1 or card.value == 2)
         return true;
 
-    auto render_color{render_color_map.at(card.color)}; 
+    auto render_color{renderColor(card.color)};
     std::vector<Color> opposite_rc_colors;
     bool safe = true;
 
     for (auto & color : colors_list) {
-        if (render_color_map.at(color) == render_color)
+        if (renderColor(color) == render_color)
             continue;
 
         if (!cardIsHome(gs, {color, card.value-1}))
@@ -289,6 +310,41 @@ std::vector<RawMove> safeHomeMoves(const GameState &gs) {
     return moves;
 }
 
+bool isDeadEnd(const GameState &gs) {
+    bool has_empty = false;
+    bool all_home = true;
+    for (const CardStorage *from : gs.non_homes) {
+        if (from->topCard().has_value())
+            all_home = false;
+        else
+            has_empty = true;
+    }
+
+    // an empty free cell or stack takes any card
+    if (all_home || has_empty)
+        return false;
+
+    for (const CardStorage *from : gs.non_homes) {
+        auto card = *from->topCard();
+        for (const CardStorage *to : gs.all_storage) {
+            if (to != from && to->canAccept(card))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void runSafeMoves(GameState &gs) {
+    std::vector<RawMove> safe_moves;
+    while ((safe_moves = safeHomeMoves(gs)), safe_moves.size() > 0) {
+        const CardStorage *from = safe_moves[0].first;
+        const CardStorage *to = safe_moves[0].second;
+
+        move(const_cast<CardStorage *>(from), const_cast<CardStorage *>(to));
+    }
+}
+
 std::ostream& operator<< (std::ostream& os, const GameState & state) {
     os << "Homes: " <<
         state.homes[0] << " " <<
@@ -326,16 +382,19 @@ std::ostream& operator<< (std::ostream& os, const Location & loc) {
     return os;
 }
 
-GameState EasyProducer::produce() {
-    GameState gs;
-
-    initializeGameState(&gs, rng_);
-    for (int i = 0; i < difficulty_; ++i) {
-        auto move = findIrreversibleMove(&gs, rng_);
+void initializeEasyDeal(GameState *gs, std::default_random_engine &rng, int difficulty) {
+    initializeGameState(gs, rng);
+    for (int i = 0; i < difficulty; ++i) {
+        auto move = findIrreversibleMove(gs, rng);
         if (!move.has_value())
             break;
         forceMove(move->first, move->second); 
     }
+}
+
+GameState EasyProducer::produce() {
+    GameState gs;
+    initializeEasyDeal(&gs, rng_, difficulty_);
 
     return gs;
 }
@@ -347,3 +406,10 @@ GameState RandomProducer::produce() {
     return gs;
 }
 
+
+GameState MsDealProducer::produce() {
+    GameState gs;
+    initializeMsDeal(&gs, next_deal_++);
+
+    return gs;
+}
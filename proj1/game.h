@@ -5,6 +5,7 @@
 #include "move.h"
 
 #include <array>
+#include <cstdint>
 #include <random>
 
 inline constexpr int nb_freecells = 4;
@@ -48,6 +49,12 @@ std::optional<std::pair<CardStorage *, WorkStack *>> findIrreversibleMove(GameSt
 
 void initializeFullRandom(GameState *gs, std::default_random_engine &rng) ;
 
+// solved game with up to `difficulty` random reverse moves applied
+void initializeEasyDeal(GameState *gs, std::default_random_engine &rng, int difficulty) ;
+
+// deals the game with the given number of the classic Microsoft FreeCell numbering
+void initializeMsDeal(GameState *gs, std::uint32_t deal_number) ;
+
 void forceMove(CardStorage *from, WorkStack *to) ;
 
 std::vector<Card> topCards(const GameState &gs) ;
@@ -60,6 +67,13 @@ Location locFromPtr(const GameState &gs, const CardStorage *ptr) ;
 
 std::vector<RawMove> safeHomeMoves(const GameState &gs) ;
 
+// Not solved, yet no card can move anywhere, so the game is lost.
+// Checked without allocating, as it runs on every generated state.
+bool isDeadEnd(const GameState &gs) ;
+
+// plays the first of safeHomeMoves() until there are none left
+void runSafeMoves(GameState &gs) ;
+
 class InitialStateProducerItf {
 public:
     virtual GameState produce() =0;
@@ -83,5 +97,14 @@ private:
     int difficulty_;
 };
 
+// Produces consecutive deals of the Microsoft FreeCell numbering,
+// identical across platforms and comparable with published benchmarks
+class MsDealProducer : public InitialStateProducerItf {
+public:
+    MsDealProducer(std::uint32_t first_deal) : next_deal_(first_deal) {}
+    GameState produce() override;
+private:
+    std::uint32_t next_deal_;
+};
 
 #endif
@@ -0,0 +1,59 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+size_t LogHistogram::bucketIndex(std::uint64_t value) {
+    if (value < sub_bucket_count)
+        return value;
+
+    int msb = 63;
+    while (!(value >> msb))
+        --msb;
+
+    // keep the sub_bucket_bits most significant bits of the value
+    int shift = msb - (sub_bucket_bits - 1);
+    std::uint64_t sub_bucket = value >> shift;
+    return shift * sub_bucket_half + sub_bucket;
+}
+
+std::uint64_t LogHistogram::bucketUpperBound(size_t index) {
+    if (index < sub_bucket_count)
+        return index;
+
+    int shift = index / sub_bucket_half - 1;
+    std::uint64_t sub_bucket = index - shift * sub_bucket_half;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LogHistogram::record(std::uint64_t value) {
+    counts_[bucketIndex(value)]++;
+    count_++;
+    max_ = std::max(max_, value);
+}
+
+LogHistogram& LogHistogram::operator+=(const LogHistogram &other) {
+    for (size_t i = 0; i < nb_buckets; ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+
+    return *this;
+}
+
+std::uint64_t LogHistogram::percentile(double percent) const {
+    if (count_ == 0)
+        return 0;
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * count_));
+    rank = std::clamp<std::uint64_t>(rank, 1, count_);
+
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < nb_buckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank)
+            return std::min(bucketUpperBound(i), max_);
+    }
+
+    return max_;
+}
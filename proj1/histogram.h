@@ -0,0 +1,39 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Log-bucketed (HDR-style) histogram of non-negative integer samples.
+// Values below 32 are kept exactly, larger ones in buckets whose width is
+// at most 1/16 of their lower bound, so any reported percentile is within
+// ~6 % of the true value. Histograms filled by different threads can be
+// combined with operator+=.
+class LogHistogram {
+public:
+    void record(std::uint64_t value);
+    LogHistogram& operator+=(const LogHistogram &other);
+
+    // smallest recorded value such that `percent` % of samples are not larger,
+    // up to the bucket resolution
+    std::uint64_t percentile(double percent) const;
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max() const { return max_; }
+
+private:
+    static constexpr int sub_bucket_bits = 5;
+    static constexpr std::uint64_t sub_bucket_count = 1 << sub_bucket_bits;
+    static constexpr std::uint64_t sub_bucket_half = sub_bucket_count / 2;
+    static constexpr size_t nb_buckets = (64 - sub_bucket_bits + 1) * sub_bucket_half + sub_bucket_half;
+
+    static size_t bucketIndex(std::uint64_t value);
+    static std::uint64_t bucketUpperBound(size_t index);
+
+    std::array<std::uint64_t, nb_buckets> counts_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+#endif
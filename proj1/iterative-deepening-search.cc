@@ -0,0 +1,131 @@
+#include "search-strategies.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// Always-replace table of states searched without success,
+// with the number of moves that were left to them.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t size) : entries_(size) {}
+
+    bool failedWithin(size_t hash, int moves_left) const {
+        if (entries_.empty())
+            return false;
+        const auto &entry = entries_[hash % entries_.size()];
+        return entry.hash == hash && entry.moves_left >= moves_left;
+    }
+
+    void storeFailure(size_t hash, int moves_left) {
+        if (!entries_.empty())
+            entries_[hash % entries_.size()] = {hash, moves_left};
+    }
+
+private:
+    struct Entry {
+        size_t hash = 0;
+        int moves_left = -1;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+struct Frame {
+    std::vector<SearchAction> actions;
+    size_t next;        // actions[next - 1] is the one applied below this frame
+    int depth;
+    size_t hash;
+    UndoRecord undo;    // of actions[next - 1]
+    bool cut_by_path = false;  // a state of the subtree was skipped for being on the path
+};
+
+}
+
+std::vector<SearchAction> IterativeDeepeningSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	stats_ = {};
+    if (init_state.isFinal())
+        return {};
+
+    TranspositionTable tt(tt_size_);
+    SearchState state(init_state);
+    std::vector<Frame> frames;
+    std::unordered_set<size_t> on_path;
+
+    for (int limit = 1; limit <= depth_limit_; ++limit) {
+        bool cut_by_limit = false;  // otherwise, a deeper search would not find anything either
+
+        frames.clear();
+        frames.push_back({state.actions(), 0, 0, hash(state), {}});
+        on_path = {frames.back().hash};
+
+        while (!frames.empty()) {
+            if (cancel.memoryCheck() == CancellationToken::MemVerdict::GiveUp)
+                return {};
+
+            Frame &frame = frames.back();
+            if (frame.next == frame.actions.size()) {
+                // A state skipped for being on the path may still lead to a solution
+                // when reached by another path, so such a failure is not remembered.
+                bool cut_by_path = frame.cut_by_path;
+                if (!cut_by_path)
+                    tt.storeFailure(frame.hash, limit - frame.depth);
+                on_path.erase(frame.hash);
+                frames.pop_back();
+                if (!frames.empty()) {
+                    frames.back().cut_by_path |= cut_by_path;
+                    state.undo(frames.back().undo);
+                }
+                continue;
+            }
+
+            const SearchAction &action = frame.actions[frame.next++];
+            if (!state.apply(action, frame.undo))
+                continue;
+            stats_.nb_generated++;
+
+            if (state.isFinal()) {
+                std::vector<SearchAction> solution;
+                for (const auto &f : frames)
+                    solution.push_back(f.actions[f.next - 1]);
+                return solution;
+            }
+
+            int depth = frame.depth + 1;
+            size_t h = hash(state);
+            bool cycle = on_path.count(h) > 0;
+            frame.cut_by_path |= cycle;
+            bool prune = cycle || tt.failedWithin(h, limit - depth);
+            if (!prune && state.isDeadEnd()) {
+                stats_.nb_pruned++;
+                prune = true;
+            }
+            if (!prune && depth == limit) {
+                cut_by_limit = true;
+                prune = true;
+            }
+
+            if (prune) {
+                state.undo(frame.undo);
+                continue;
+            }
+
+            if (cancel.expand())
+                return {};
+
+            frames.push_back({SUI_PROFILED(ProfilePhase::Actions, state.actions()), 0, depth, h, {}});
+            on_path.insert(h);
+
+            stats_.peak_open = std::max(stats_.peak_open, frames.size());
+        }
+
+        if (!cut_by_limit)
+            return {};
+    }
+
+    return {};
+}
@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file.
+// On POSIX systems the file is memory-mapped, elsewhere it is read into memory.
+// Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    const std::uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::uint8_t *data_;
+    size_t size_;
+    std::vector<std::uint8_t> fallback_;
+};
+
+#endif
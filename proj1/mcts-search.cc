@@ -0,0 +1,323 @@
+#include "search-strategies.h"
+#include "packed-move.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// rewards are summed up in fixed point, as there is no atomic double addition
+constexpr double reward_scale = 1 << 16;
+
+enum NodeState : std::uint8_t {Leaf, Expanding, Expanded, DeadEnd};
+
+struct Node {
+    std::atomic<std::uint32_t> visits{0};  // counted on the way down, losses until backed up
+    std::atomic<std::uint64_t> reward{0};
+    std::atomic<std::uint8_t> state{Leaf};
+    std::uint32_t first_edge = 0;  // set before state turns Expanded
+    std::uint32_t nb_edges = 0;
+};
+
+struct Edge {
+    PackedMove move;
+    std::uint32_t child;
+};
+
+}
+
+struct MctsSearch::Tree {
+    explicit Tree(size_t max_nodes) :
+        nodes(new Node[max_nodes]),
+        edges(new Edge[2 * max_nodes]),
+        max_nodes(max_nodes),
+        max_edges(2 * max_nodes),
+        nb_nodes(1),  // the root
+        nb_edges(0),
+        full(false)
+    {}
+
+    // a new node, or none when the pool is used up
+    std::uint32_t allocate() {
+        auto index = nb_nodes.fetch_add(1, std::memory_order_relaxed);
+        if (index < max_nodes)
+            return index;
+        full = true;
+        return none;
+    }
+
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    std::unique_ptr<Node[]> nodes;
+    std::unique_ptr<Edge[]> edges;
+    size_t max_nodes;
+    size_t max_edges;
+    std::atomic<size_t> nb_nodes;
+    std::atomic<size_t> nb_edges;
+    std::atomic<bool> full;
+
+    // node of every state hash, so that transpositions share their statistics
+    std::mutex transpositions_mutex;
+    std::unordered_map<size_t, std::uint32_t> transpositions;
+};
+
+MctsSearch::MctsSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, unsigned nb_threads,
+                       size_t max_nodes, unsigned long long max_iterations,
+                       size_t playout_depth, double exploration) :
+        heuristic_(std::move(heuristic)),
+        nb_threads_(nb_threads),
+        max_nodes_(max_nodes),
+        max_iterations_(max_iterations),
+        playout_depth_(playout_depth),
+        exploration_(exploration),
+        seed_(1337) {
+}
+
+std::vector<SearchAction> MctsSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+    stats_ = {};
+    if (init_state.isFinal())
+        return {};
+
+    Tree tree(std::max<size_t>(max_nodes_, 1));
+    tree.transpositions[hash(init_state)] = 0;
+    // rewards tell how much closer to home a playout got, relative to the deal
+    const double root_heuristic = compute_heuristic(init_state, *heuristic_) + 1;
+
+    const std::uint64_t seed = seed_++;
+    std::atomic<unsigned long long> nb_iterations(0);
+    std::atomic<unsigned long long> nb_generated(0);
+    std::atomic<bool> done(false);  // solved or out of budget
+    std::mutex mutex;
+    std::vector<SearchAction> solution;
+
+    auto found = [&](const std::vector<SearchAction> &moves, const SearchAction *last) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (done && !solution.empty())
+            return;
+        solution = moves;
+        if (last)
+            solution.push_back(*last);
+        done = true;
+    };
+
+    auto work = [&](unsigned thread_index) {
+        std::seed_seq seeds{seed, static_cast<std::uint64_t>(thread_index)};
+        std::mt19937_64 rng(seeds);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        SearchState state(init_state);
+        std::vector<SearchAction> moves;
+        std::vector<UndoRecord> undos;  // of moves, kept for their capacity
+        UndoRecord probe;
+        std::vector<std::uint32_t> path;  // tree nodes of this iteration
+        std::unordered_set<size_t> on_path;
+        std::vector<size_t> child_hashes;
+        unsigned long long generated = 0;
+
+        auto apply = [&](const SearchAction &action) {
+            if (undos.size() <= moves.size())
+                undos.emplace_back();
+            state.apply(action, undos[moves.size()]);
+            moves.push_back(action);
+        };
+
+        // the leaf under the cursor gets its children, shared with their transpositions
+        auto expand = [&](std::uint32_t index) {
+            Node &node = tree.nodes[index];
+            auto actions = state.actions();
+            if (actions.empty()) {
+                node.state.store(DeadEnd, std::memory_order_release);
+                return;
+            }
+
+            child_hashes.clear();
+            for (const auto &action : actions) {
+                state.apply(action, probe);
+                generated++;
+                if (state.isFinal())
+                    found(moves, &action);
+                child_hashes.push_back(hash(state));
+                state.undo(probe);
+            }
+
+            auto first_edge = tree.nb_edges.fetch_add(actions.size(), std::memory_order_relaxed);
+            if (first_edge + actions.size() > tree.max_edges) {
+                tree.full = true;
+                node.state.store(Leaf, std::memory_order_release);
+                return;
+            }
+
+            size_t nb_edges = 0;
+            {
+                std::lock_guard<std::mutex> lock(tree.transpositions_mutex);
+                for (size_t i = 0; i < actions.size(); ++i) {
+                    auto [it, inserted] = tree.transpositions.try_emplace(child_hashes[i], Tree::none);
+                    if (inserted)
+                        it->second = tree.allocate();
+                    if (it->second == Tree::none) {
+                        tree.transpositions.erase(it);
+                        continue;  // out of nodes
+                    }
+                    tree.edges[first_edge + nb_edges++] = {PackedMove(actions[i]), it->second};
+                }
+            }
+
+            node.first_edge = first_edge;
+            node.nb_edges = nb_edges;
+            node.state.store(nb_edges > 0 ? Expanded : Leaf, std::memory_order_release);
+        };
+
+        // child by UCT, leaving out states of this iteration (the tree has cycles)
+        auto select = [&](const Node &node) {
+            const Edge *best = nullptr;
+            double best_score = -1;
+            double log_visits = std::log(std::max<std::uint32_t>(1, node.visits.load(std::memory_order_relaxed)));
+            for (std::uint32_t e = 0; e < node.nb_edges; ++e) {
+                const Edge &edge = tree.edges[node.first_edge + e];
+                const Node &child = tree.nodes[edge.child];
+                if (child.state.load(std::memory_order_relaxed) == DeadEnd)
+                    continue;
+
+                double visits = child.visits.load(std::memory_order_relaxed);
+                double score = visits == 0 ? std::numeric_limits<double>::infinity() :
+                    child.reward.load(std::memory_order_relaxed) / reward_scale / visits +
+                    exploration_ * std::sqrt(log_visits / visits);
+                if (score <= best_score)
+                    continue;
+
+                state.apply(edge.move.action(), probe);
+                bool repeated = on_path.count(hash(state)) > 0;
+                state.undo(probe);
+                if (!repeated) {
+                    best = &edge;
+                    best_score = score;
+                }
+            }
+            return best;
+        };
+
+        // heuristic-guided: mostly the successor with the lowest heuristic
+        auto playout = [&]() {
+            double heuristic = compute_heuristic(state, *heuristic_);
+            for (size_t depth = 0; depth < playout_depth_ && !done; ++depth) {
+                auto actions = state.actions();
+                const SearchAction *chosen = nullptr;
+                double chosen_heuristic = std::numeric_limits<double>::infinity();
+                bool explore = uniform(rng) < 0.2;
+                size_t nb_candidates = 0;
+                for (const auto &action : actions) {
+                    state.apply(action, probe);
+                    generated++;
+                    if (state.isFinal()) {
+                        state.undo(probe);
+                        found(moves, &action);
+                        return 1.0;
+                    }
+
+                    if (!on_path.count(hash(state))) {
+                        double next_heuristic = compute_heuristic(state, *heuristic_);
+                        // a random candidate when exploring (reservoir sampling), the best otherwise
+                        bool take = explore ? rng() % ++nb_candidates == 0 : next_heuristic < chosen_heuristic;
+                        if (take) {
+                            chosen = &action;
+                            chosen_heuristic = next_heuristic;
+                        }
+                    }
+                    state.undo(probe);
+                }
+
+                if (chosen == nullptr)
+                    break;
+                apply(*chosen);
+                on_path.insert(hash(state));
+                heuristic = chosen_heuristic;
+            }
+
+            return std::clamp(1 - heuristic / root_heuristic, 0.0, 1.0);
+        };
+
+        while (!done) {
+            if (nb_iterations++ >= max_iterations_ || cancel.expand()) {
+                done = true;
+                break;
+            }
+
+            // selection down the tree, every node visited counts as lost until backed up
+            std::uint32_t index = 0;
+            path = {0};
+            on_path = {hash(state)};
+            tree.nodes[0].visits++;
+            double reward = 0;
+            bool play_out = true;
+
+            while (!done) {
+                Node &node = tree.nodes[index];
+                auto node_state = node.state.load(std::memory_order_acquire);
+
+                // a leaf is expanded the second time it is reached
+                std::uint8_t leaf = Leaf;
+                if (node_state == Leaf && node.visits.load(std::memory_order_relaxed) > 1 && !tree.full &&
+                        node.state.compare_exchange_strong(leaf, Expanding, std::memory_order_acquire)) {
+                    expand(index);
+                    node_state = node.state.load(std::memory_order_acquire);
+                }
+
+                if (node_state == DeadEnd)
+                    play_out = false;
+                if (node_state != Expanded)
+                    break;
+
+                const Edge *edge = select(node);
+                if (edge == nullptr) {
+                    play_out = false;  // everything from here leads back
+                    break;
+                }
+
+                apply(edge->move.action());
+                on_path.insert(hash(state));
+                index = edge->child;
+                path.push_back(index);
+                tree.nodes[index].visits++;
+                if (state.isFinal()) {
+                    found(moves, nullptr);
+                    break;
+                }
+            }
+
+            if (play_out && !done)
+                reward = playout();
+
+            for (auto node : path)
+                tree.nodes[node].reward += static_cast<std::uint64_t>(reward * reward_scale);
+
+            // back to the deal for the next iteration
+            while (!moves.empty()) {
+                moves.pop_back();
+                state.undo(undos[moves.size()]);
+            }
+        }
+
+        nb_generated += generated;
+    };
+
+    WorkerProfiles profiles(nb_threads_);
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nb_threads_; ++t)
+        threads.emplace_back([&, t]() { work(t); profiles.save(t); });
+    work(0);
+    for (auto &thread : threads)
+        thread.join();
+    profiles.collect();
+
+    stats_.nb_generated = nb_generated;
+    stats_.peak_closed = std::min(tree.nb_nodes.load(), tree.max_nodes);
+    return solution;
+}
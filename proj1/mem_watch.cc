@@ -3,6 +3,9 @@
 #include "memusage.h"
 
 #include <iostream>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 #include <thread>
 #include <cmath>
 
@@ -20,23 +23,56 @@ struct HumanReadable {
     }
 };
 
-void MemWatcher::run() const {
+void MemWatcher::run() {
     while (!stop_) {
-        auto mem = getCurrentRSS();
-        
-        if (mem > mem_limit_) {
-            std::cout << report_;
-            std::cerr << "MEM: Already taken " << HumanReadable{mem} <<
-                " which is " << HumanReadable{mem - mem_limit_} <<
-                " over the limit of " << HumanReadable{mem_limit_} <<
-                ". Aborting.\n";
-            std::abort();
-        }
-
+        sample_();
         std::this_thread::sleep_for(period_);
     }
 }
 
+void MemWatcher::sample_() {
+    auto mem = getCurrentRSS();
+    
+    if (mem > hard_limit_) {
+        std::cout << report_;
+        std::cerr << "MEM: Already taken " << HumanReadable{mem} <<
+            " which is " << HumanReadable{mem - hard_limit_} <<
+            " over the limit of " << HumanReadable{hard_limit_} <<
+            ". Aborting.\n";
+        std::abort();
+    }
+
+    last_rss_ = mem;
+    under_pressure_ = mem > soft_limit_;
+
+    // also sampled from solver threads through releaseFreedMemory()
+    auto peak = peak_rss_.load();
+    while (mem > peak && !peak_rss_.compare_exchange_weak(peak, mem)) {}
+}
+
+void MemWatcher::releaseFreedMemory() {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+    sample_();
+}
+
 void MemWatcher::kill() {
     stop_ = true;
 }
+
+bool MemWatcher::underPressure() const {
+    return under_pressure_;
+}
+
+size_t MemWatcher::lastRSS() const {
+    return last_rss_;
+}
+
+size_t MemWatcher::peakRSS() const {
+    return peak_rss_;
+}
+
+void MemWatcher::resetPeakRSS() {
+    peak_rss_ = 0;
+}
@@ -6,18 +6,43 @@
 #include <chrono>
 #include <atomic>
 
+// Periodically samples the resident memory usage.
+// Crossing the soft watermark only raises a pressure signal that running
+// strategies observe (through their CancellationToken) and react to.
+// Crossing the hard watermark prints the report collected so far and aborts.
 class MemWatcher {
 public:
-    MemWatcher(size_t limit, std::chrono::milliseconds period, const StrategyEvaluation &report) :
-        mem_limit_(limit), period_(period), stop_(false), report_(report) {}
+    MemWatcher(size_t soft_limit, size_t hard_limit, std::chrono::milliseconds period, const StrategyEvaluation &report) :
+        soft_limit_(soft_limit), hard_limit_(hard_limit), period_(period),
+        stop_(false), under_pressure_(false), last_rss_(0), peak_rss_(0), report_(report) {}
 
-    void run() const;
+    void run();
     void kill();
 
+    bool underPressure() const;
+    // RSS at the last sample
+    size_t lastRSS() const;
+
+    // The allocator tends to keep memory freed by a finished search, so RSS
+    // stays above the soft watermark and the next deal would start under
+    // pressure. Called between deals, this hands the memory back to the
+    // OS (where supported) and takes a fresh sample.
+    void releaseFreedMemory();
+
+    // highest sampled RSS since the last reset, e.g. over a single deal
+    size_t peakRSS() const;
+    void resetPeakRSS();
+
 private:
-    size_t mem_limit_;
+    void sample_();
+
+    size_t soft_limit_;
+    size_t hard_limit_;
     std::chrono::milliseconds period_;
     std::atomic<bool> stop_;
+    std::atomic<bool> under_pressure_;
+    std::atomic<size_t> last_rss_;
+    std::atomic<size_t> peak_rss_;
     const StrategyEvaluation &report_;
 };
 
@@ -0,0 +1,75 @@
+#include "packed-move.h"
+
+#include <stdexcept>
+
+static std::uint8_t locationNibble(const Location &loc) {
+    switch (loc.cl) {
+        case LocationClass::FreeCells:
+            return loc.id;
+        case LocationClass::Stacks:
+            return nb_freecells + loc.id;
+        case LocationClass::Homes:
+        default:
+            return nb_freecells + nb_stacks + loc.id;
+    }
+}
+
+static Location locationFromNibble(std::uint8_t nibble) {
+    if (nibble < nb_freecells)
+        return {LocationClass::FreeCells, nibble};
+    else if (nibble < nb_freecells + nb_stacks)
+        return {LocationClass::Stacks, nibble - nb_freecells};
+    else
+        return {LocationClass::Homes, nibble - nb_freecells - nb_stacks};
+}
+
+PackedMove::PackedMove(const SearchAction &action) :
+    PackedMove(action.from(), action.to())
+{}
+
+PackedMove::PackedMove(const Location &from, const Location &to) :
+    byte_(locationNibble(from) << 4 | locationNibble(to))
+{}
+
+SearchAction PackedMove::action() const {
+    return SearchAction(from(), to());
+}
+
+Location PackedMove::from() const {
+    return locationFromNibble(byte_ >> 4);
+}
+
+Location PackedMove::to() const {
+    return locationFromNibble(byte_ & 0xf);
+}
+
+static char locationSymbol(std::uint8_t nibble) {
+    if (nibble < nb_freecells)
+        return 'a' + nibble;
+    else if (nibble < nb_freecells + nb_stacks)
+        return '1' + nibble - nb_freecells;
+    else
+        return 'w' + nibble - nb_freecells - nb_stacks;
+}
+
+static std::uint8_t nibbleFromSymbol(char symbol) {
+    if (symbol >= 'a' && symbol < 'a' + nb_freecells)
+        return symbol - 'a';
+    else if (symbol >= '1' && symbol < '1' + nb_stacks)
+        return nb_freecells + symbol - '1';
+    else if (symbol >= 'w' && symbol < 'w' + nb_homes)
+        return nb_freecells + nb_stacks + symbol - 'w';
+    else
+        throw std::invalid_argument(std::string("Unknown location '") + symbol + "'");
+}
+
+std::string moveText(PackedMove move) {
+    return {locationSymbol(move.byte() >> 4), locationSymbol(move.byte() & 0xf)};
+}
+
+PackedMove moveFromText(const std::string &text) {
+    if (text.size() != 2)
+        throw std::invalid_argument("Malformed move '" + text + "'");
+
+    return PackedMove(static_cast<std::uint8_t>(nibbleFromSymbol(text[0]) << 4 | nibbleFromSymbol(text[1])));
+}
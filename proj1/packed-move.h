@@ -0,0 +1,43 @@
+#ifndef PACKED_MOVE_H
+#define PACKED_MOVE_H
+
+#include "search-interface.h"
+
+#include <cstdint>
+#include <string>
+
+// A SearchAction in a single byte: the source location in the high nibble,
+// the destination in the low one. Locations are numbered
+//   0..3    free cells
+//   4..11   work stacks
+//   12..15  home destinations
+class PackedMove {
+public:
+    PackedMove() : byte_(0) {}
+    explicit PackedMove(std::uint8_t byte) : byte_(byte) {}
+    explicit PackedMove(const SearchAction &action);
+    PackedMove(const Location &from, const Location &to);
+
+    SearchAction action() const;
+    Location from() const;
+    Location to() const;
+
+    std::uint8_t byte() const { return byte_; }
+
+    friend bool operator==(PackedMove a, PackedMove b) { return a.byte_ == b.byte_; }
+    friend bool operator!=(PackedMove a, PackedMove b) { return a.byte_ != b.byte_; }
+
+private:
+    std::uint8_t byte_;
+};
+
+static_assert(sizeof(PackedMove) == 1);
+
+// Text form of a move, two characters for source and destination:
+// free cells 'a'..'d', work stacks '1'..'8', homes 'w'..'z'; e.g. "3a" or "bw".
+std::string moveText(PackedMove move) ;
+
+// Throws std::invalid_argument unless `text` is a move in the form above.
+PackedMove moveFromText(const std::string &text) ;
+
+#endif
@@ -0,0 +1,146 @@
+#include "packed-state.h"
+
+#include <stdexcept>
+
+int cardIndex(const Card &card) {
+    return static_cast<int>(card.color) * king_value + card.value - 1;
+}
+
+Card cardFromIndex(int index) {
+    return {colors_list[index / king_value], index % king_value + 1};
+}
+
+PackedState packState(const GameState &gs) {
+    PackedState packed;
+
+    for (const auto &home : gs.homes) {
+        auto opt_top = home.topCard();
+        if (!opt_top.has_value())
+            continue;
+
+        for (int value = 1; value <= opt_top->value; ++value)
+            packed[cardIndex({opt_top->color, value})] = packed_home;
+    }
+
+    for (size_t i = 0; i < gs.free_cells.size(); ++i) {
+        auto opt_card = gs.free_cells[i].topCard();
+        if (opt_card.has_value())
+            packed[cardIndex(*opt_card)] = packed_free_cell + i;
+    }
+
+    for (size_t i = 0; i < gs.stacks.size(); ++i) {
+        std::uint8_t below = packed_stack_bottom + i;
+        for (const auto &card : gs.stacks[i].storage()) {
+            auto index = cardIndex(card);
+            packed[index] = below;
+            below = index;
+        }
+    }
+
+    return packed;
+}
+
+std::uint64_t hashPackedState(const PackedState &packed) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto byte : packed) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+PackedState canonicalFreeCells(PackedState packed) {
+    std::uint8_t next = packed_free_cell;
+    for (auto &below : packed) {
+        if (below >= packed_free_cell && below < packed_home)
+            below = next++;
+    }
+
+    return packed;
+}
+
+GameState unpackState(const PackedState &packed) {
+    constexpr int none = -1;
+    std::array<int, nb_cards> above;
+    std::array<int, nb_stacks> bottoms;
+    above.fill(none);
+    bottoms.fill(none);
+
+    GameState gs;
+    int nb_placed = 0;
+    std::array<int, nb_homes> nb_home{};
+
+    for (int index = 0; index < nb_cards; ++index) {
+        auto below = packed[index];
+        if (below < packed_stack_bottom) {
+            if (above[below] != none)
+                throw std::invalid_argument("Two cards placed on the same card");
+            above[below] = index;
+        } else if (below < packed_free_cell) {
+            if (bottoms[below - packed_stack_bottom] != none)
+                throw std::invalid_argument("Two cards at the bottom of the same stack");
+            bottoms[below - packed_stack_bottom] = index;
+        } else if (below < packed_home) {
+            if (!gs.free_cells[below - packed_free_cell].acceptCard(cardFromIndex(index)))
+                throw std::invalid_argument("Two cards in the same free cell");
+            nb_placed++;
+        } else if (below == packed_home) {
+            nb_home[index / king_value]++;
+        } else {
+            throw std::invalid_argument("Invalid location byte in a packed state");
+        }
+    }
+
+    for (size_t i = 0; i < colors_list.size(); ++i) {
+        for (int value = 1; value <= nb_home[i]; ++value) {
+            Card card{colors_list[i], value};
+            if (packed[cardIndex(card)] != packed_home)
+                throw std::invalid_argument("Home destination with a gap");
+            gs.homes[i].acceptCard(card);
+            nb_placed++;
+        }
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (int index = bottoms[i]; index != none && nb_placed < nb_cards; index = above[index]) {
+            gs.stacks[i].forceCard(cardFromIndex(index));
+            nb_placed++;
+        }
+    }
+
+    // cards sitting on a cycle or on a home/free cell card are never reached
+    if (nb_placed != nb_cards)
+        throw std::invalid_argument("Packed state does not place all cards");
+
+    return gs;
+}
+
+HomeOrder homeOrder(const GameState &gs) {
+    HomeOrder order;
+    for (int i = 0; i < nb_homes; ++i) {
+        auto opt_top = gs.homes[i].topCard();
+        order[i] = opt_top.has_value() ? cardIndex(*opt_top) / king_value : no_home_color;
+    }
+
+    return order;
+}
+
+GameState unpackState(const PackedState &packed, const HomeOrder &order) {
+    GameState gs = unpackState(packed);
+
+    for (int i = 0; i < nb_homes; ++i) {
+        if (order[i] == no_home_color)
+            continue;
+
+        for (int j = i; j < nb_homes; ++j) {
+            auto opt_top = gs.homes[j].topCard();
+            if (opt_top.has_value() && cardIndex(*opt_top) / king_value == order[i]) {
+                std::swap(gs.homes[i], gs.homes[j]);
+                break;
+            }
+        }
+    }
+
+    return gs;
+}
@@ -0,0 +1,56 @@
+#ifndef PACKED_STATE_H
+#define PACKED_STATE_H
+
+#include "game.h"
+
+#include <array>
+#include <cstdint>
+
+inline constexpr int nb_cards = 52;
+
+// Compact, canonical encoding of a GameState in 52 bytes.
+// Byte i describes card i (see cardIndex()) by what lies directly below it:
+//   0..51   the card with that index (same work stack)
+//   52..59  the bottom of work stack (value - 52)
+//   60..63  free cell (value - 60)
+//   64      its home destination
+// Homes are identified by color only, so two states differing just in
+// the order of their home destinations pack to the same bytes.
+using PackedState = std::array<std::uint8_t, nb_cards>;
+
+inline constexpr std::uint8_t packed_stack_bottom = 52;
+inline constexpr std::uint8_t packed_free_cell = 60;
+inline constexpr std::uint8_t packed_home = 64;
+
+int cardIndex(const Card &card) ;
+Card cardFromIndex(int index) ;
+
+PackedState packState(const GameState &gs) ;
+
+// The same layout with the free cell cards moved to the lowest free cells,
+// ordered by card index: layouts differing only in which free cell holds
+// which card map to the same bytes.
+PackedState canonicalFreeCells(PackedState packed) ;
+
+// 64-bit FNV-1a hash of the packed bytes
+std::uint64_t hashPackedState(const PackedState &packed) ;
+
+struct PackedStateHash {
+    size_t operator()(const PackedState &packed) const { return hashPackedState(packed); }
+};
+
+// Rebuilds the state with the home of colors_list[i] at homes[i].
+// Throws std::invalid_argument if the bytes do not describe a valid layout.
+GameState unpackState(const PackedState &packed) ;
+
+// What packState() leaves out: the color (index into colors_list) of the
+// cards at each of gs.homes, or no_home_color for an empty home.
+using HomeOrder = std::array<std::uint8_t, nb_homes>;
+inline constexpr std::uint8_t no_home_color = 0xff;
+
+HomeOrder homeOrder(const GameState &gs) ;
+
+// Rebuilds exactly the state that was packed, homes in the given order.
+GameState unpackState(const PackedState &packed, const HomeOrder &order) ;
+
+#endif
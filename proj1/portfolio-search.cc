@@ -0,0 +1,56 @@
+#include "search-strategies.h"
+#include "replay-board.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+std::vector<SearchAction> PortfolioSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+    stats_ = {};
+
+    std::deque<CancellationToken> tokens;  // not movable, so not in a vector
+    for (size_t i = 0; i < members_.size(); ++i)
+        tokens.emplace_back(cancel);
+
+    std::mutex mutex;
+    std::vector<SearchAction> solution;
+    std::string winner;
+
+    WorkerProfiles profiles(members_.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < members_.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            auto found = members_[i].strategy->solve(init_state, tokens[i]);
+            profiles.save(i);
+            if (found.empty() || !replaySolves(init_state, found))
+                return;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!winner.empty())
+                return;  // somebody was faster
+            solution = std::move(found);
+            winner = members_[i].name;
+            for (auto &token : tokens)
+                token.cancel();
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    profiles.collect();
+
+    for (const auto &member : members_) {
+        const SearchStats &stats = member.strategy->stats();
+        stats_.nb_generated += stats.nb_generated;
+        stats_.nb_pruned += stats.nb_pruned;
+        stats_.nb_closed_hits += stats.nb_closed_hits;
+        stats_.closed_fp_rate = std::max(stats_.closed_fp_rate, stats.closed_fp_rate);
+        // they ran at the same time, so the peaks add up
+        stats_.peak_open += stats.peak_open;
+        stats_.peak_closed += stats.peak_closed;
+    }
+    stats_.winner = winner;
+
+    return solution;
+}
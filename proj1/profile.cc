@@ -0,0 +1,32 @@
+#include "profile.h"
+
+PhaseProfile& PhaseProfile::operator+=(const PhaseProfile &other) {
+    for (size_t i = 0; i < nb_profile_phases; ++i) {
+        nb_calls[i] += other.nb_calls[i];
+        time[i] += other.time[i];
+    }
+
+    return *this;
+}
+
+std::ostream& operator<< (std::ostream& os, const PhaseProfile &profile) {
+    static const std::array<const char *, nb_profile_phases> names{
+        "actions", "state copy", "safe moves", "heuristic", "closed set", "open list"
+    };
+
+    os << "Profile:";
+    for (size_t i = 0; i < nb_profile_phases; ++i) {
+        os << " " << names[i] << " " << profile.nb_calls[i] << "x " <<
+            std::chrono::duration_cast<std::chrono::microseconds>(profile.time[i]).count() << " us" <<
+            (i + 1 < nb_profile_phases ? "," : "\n");
+    }
+
+    return os;
+}
+
+#ifdef SUI_PROFILE
+PhaseProfile& threadProfile() {
+    thread_local PhaseProfile profile;
+    return profile;
+}
+#endif
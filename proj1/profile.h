@@ -0,0 +1,92 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+// Hot-path phases of a solve that can be timed
+enum class ProfilePhase {Actions, StateCopy, SafeMoves, Heuristic, ClosedSet, OpenList};
+inline constexpr size_t nb_profile_phases = 6;
+
+struct PhaseProfile {
+    std::array<unsigned long long, nb_profile_phases> nb_calls{};
+    std::array<std::chrono::nanoseconds, nb_profile_phases> time{};
+
+    PhaseProfile& operator+=(const PhaseProfile &other);
+};
+
+std::ostream& operator<< (std::ostream& os, const PhaseProfile &profile) ;
+
+// Instrumentation is compiled in only with -DSUI_PROFILE (make PROFILE=1).
+// Otherwise SUI_PROFILE_SCOPE expands to nothing and SUI_PROFILED(phase, expr)
+// to plain (expr).
+#ifdef SUI_PROFILE
+
+// accumulator of the calling thread, reset and collected around each solve
+PhaseProfile& threadProfile();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase) :
+        phase_(phase), t0_(std::chrono::steady_clock::now()) {}
+
+    ~ProfileScope() {
+        auto &profile = threadProfile();
+        auto i = static_cast<size_t>(phase_);
+        profile.nb_calls[i]++;
+        profile.time[i] += std::chrono::steady_clock::now() - t0_;
+    }
+
+private:
+    ProfilePhase phase_;
+    std::chrono::steady_clock::time_point t0_;
+};
+
+template <typename F>
+decltype(auto) profiled(ProfilePhase phase, F &&f) {
+    ProfileScope scope(phase);
+    return f();
+}
+
+#define SUI_PROFILE_CONCAT_(a, b) a##b
+#define SUI_PROFILE_CONCAT(a, b) SUI_PROFILE_CONCAT_(a, b)
+#define SUI_PROFILE_SCOPE(phase) ProfileScope SUI_PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#define SUI_PROFILED(phase, expr) profiled((phase), [&]() -> decltype(auto) { return (expr); })
+
+// Only the profile of the thread calling solve() gets collected, so threads
+// working for it hand theirs over: worker i calls save(i) as it finishes and
+// the solving thread calls collect() once it has joined them all.
+class WorkerProfiles {
+public:
+    explicit WorkerProfiles(size_t nb_workers) : profiles_(nb_workers) {}
+
+    void save(size_t worker) { profiles_[worker] = std::exchange(threadProfile(), {}); }
+    void collect() {
+        for (const auto &profile : profiles_)
+            threadProfile() += profile;
+    }
+
+private:
+    std::vector<PhaseProfile> profiles_;
+};
+
+#else
+
+#define SUI_PROFILE_SCOPE(phase)
+#define SUI_PROFILED(phase, expr) (expr)
+
+class WorkerProfiles {
+public:
+    explicit WorkerProfiles(size_t) {}
+
+    void save(size_t) {}
+    void collect() {}
+};
+
+#endif
+
+#endif
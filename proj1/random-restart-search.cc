@@ -0,0 +1,142 @@
+#include "search-strategies.h"
+#include "profile.h"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+// 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ... for i = 1, 2, ...
+unsigned long long luby(unsigned long long i) {
+    for (;;) {
+        int k = 1;
+        while ((1ull << k) - 1 < i)
+            ++k;
+        if ((1ull << k) - 1 == i)
+            return 1ull << (k - 1);
+        i -= (1ull << (k - 1)) - 1;
+    }
+}
+
+}
+
+RandomRestartSearch::RandomRestartSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic,
+                                         unsigned nb_threads, size_t rollout_unit,
+                                         unsigned long long max_rollouts, double temperature) :
+        heuristic_(std::move(heuristic)),
+        nb_threads_(nb_threads),
+        rollout_unit_(rollout_unit),
+        max_rollouts_(max_rollouts),
+        temperature_(temperature),
+        seed_(1337) {
+}
+
+std::vector<SearchAction> RandomRestartSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+    stats_ = {};
+    if (init_state.isFinal())
+        return {};
+
+    const std::uint64_t seed = seed_++;
+    std::atomic<unsigned long long> next_rollout(1);
+    std::atomic<unsigned long long> nb_generated(0);
+    std::atomic<bool> done(false);  // solved or out of budget
+    std::mutex mutex;
+    std::vector<SearchAction> solution;
+
+    auto work = [&](unsigned thread_index) {
+        std::seed_seq seeds{seed, static_cast<std::uint64_t>(thread_index)};
+        std::mt19937_64 rng(seeds);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        SearchState state(init_state);
+        std::vector<SearchAction> moves;
+        std::vector<UndoRecord> undos;  // of moves, kept for their capacity
+        UndoRecord probe;
+        std::vector<double> weights;
+        std::unordered_set<size_t> on_path;
+        unsigned long long generated = 0;
+
+        for (unsigned long long rollout = next_rollout++; !done && rollout <= max_rollouts_; rollout = next_rollout++) {
+            size_t length = luby(rollout) * rollout_unit_;
+            on_path = {hash(state)};
+
+            while (moves.size() < length && !done) {
+                if (cancel.expand()) {
+                    done = true;
+                    break;
+                }
+
+                // the heuristic of every successor not on this rollout yet
+                auto actions = state.actions();
+                weights.assign(actions.size(), std::numeric_limits<double>::infinity());
+                double best = std::numeric_limits<double>::infinity();
+                for (size_t i = 0; i < actions.size(); ++i) {
+                    if (!state.apply(actions[i], probe))
+                        continue;
+                    generated++;
+
+                    if (state.isFinal()) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!done) {
+                            solution = moves;
+                            solution.push_back(actions[i]);
+                            done = true;
+                        }
+                    } else if (!on_path.count(hash(state))) {
+                        weights[i] = compute_heuristic(state, *heuristic_);
+                        best = std::min(best, weights[i]);
+                    }
+                    state.undo(probe);
+                }
+
+                if (done || best == std::numeric_limits<double>::infinity())
+                    break;  // solved, or nowhere new to go
+
+                // softmax over how much the heuristic improves, the best weighs 1
+                double total = 0;
+                for (auto &weight : weights) {
+                    weight = std::exp((best - weight) / temperature_);
+                    total += weight;
+                }
+
+                double pick = uniform(rng) * total;
+                size_t chosen = 0;
+                while (chosen + 1 < weights.size() && (pick -= weights[chosen]) >= 0)
+                    ++chosen;
+                while (weights[chosen] == 0.0)  // rounding took the pick past the last candidate
+                    --chosen;
+
+                if (undos.size() <= moves.size())
+                    undos.emplace_back();
+                state.apply(actions[chosen], undos[moves.size()]);
+                moves.push_back(actions[chosen]);
+                on_path.insert(hash(state));
+            }
+
+            // back to the deal for the next rollout
+            while (!moves.empty()) {
+                moves.pop_back();
+                state.undo(undos[moves.size()]);
+            }
+        }
+
+        nb_generated += generated;
+    };
+
+    WorkerProfiles profiles(nb_threads_);
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nb_threads_; ++t)
+        threads.emplace_back([&, t]() { work(t); profiles.save(t); });
+    work(0);
+    for (auto &thread : threads)
+        thread.join();
+    profiles.collect();
+
+    stats_.nb_generated = nb_generated;
+    return solution;
+}
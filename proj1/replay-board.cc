@@ -0,0 +1,252 @@
+#include "replay-board.h"
+
+#include <stdexcept>
+
+static constexpr int cardColor(std::uint8_t card) { return card >> 4; }
+static constexpr int cardValue(std::uint8_t card) { return card & 0xf; }
+static constexpr bool isRed(int color) { return color < 2; }  // hearts and diamonds
+
+static std::uint8_t cardByte(const Card &card) {
+    return static_cast<int>(card.color) << 4 | card.value;
+}
+
+static Card cardFromByte(std::uint8_t card) {
+    return {static_cast<Color>(cardColor(card)), cardValue(card)};
+}
+
+ReplayBoard::ReplayBoard(const GameState &gs) : free_cells_{}, homes_{}, stacks_{}, stack_sizes_{} {
+    for (int i = 0; i < nb_freecells; ++i) {
+        auto opt_card = gs.free_cells[i].topCard();
+        if (opt_card.has_value())
+            free_cells_[i] = cardByte(*opt_card);
+    }
+
+    for (int i = 0; i < nb_homes; ++i) {
+        auto opt_top = gs.homes[i].topCard();
+        if (opt_top.has_value())
+            homes_[i] = cardByte(*opt_top);
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (const auto &card : gs.stacks[i].storage())
+            stacks_[i][stack_sizes_[i]++] = cardByte(card);
+    }
+}
+
+ReplayBoard::ReplayBoard(const SearchState &state) : ReplayBoard(state.state_) {}
+
+ReplayBoard::ReplayBoard(const PackedState &packed) : free_cells_{}, homes_{}, stacks_{}, stack_sizes_{} {
+    constexpr int none = -1;
+    std::array<int, nb_cards> above;
+    std::array<int, nb_stacks> bottoms;
+    above.fill(none);
+    bottoms.fill(none);
+
+    auto byteFromIndex = [](int index) -> CardByte { return (index / king_value) << 4 | (index % king_value + 1); };
+
+    int nb_placed = 0;
+    for (int index = 0; index < nb_cards; ++index) {
+        auto below = packed[index];
+        if (below < packed_stack_bottom) {
+            if (above[below] != none)
+                throw std::invalid_argument("Two cards placed on the same card");
+            above[below] = index;
+        } else if (below < packed_free_cell) {
+            if (bottoms[below - packed_stack_bottom] != none)
+                throw std::invalid_argument("Two cards at the bottom of the same stack");
+            bottoms[below - packed_stack_bottom] = index;
+        } else if (below < packed_home) {
+            if (free_cells_[below - packed_free_cell] != 0)
+                throw std::invalid_argument("Two cards in the same free cell");
+            free_cells_[below - packed_free_cell] = byteFromIndex(index);
+            nb_placed++;
+        } else if (below == packed_home) {
+            // homes are laid out as by unpackState(), one color per home in colors_list order
+            homes_[index / king_value]++;
+            nb_placed++;
+        } else {
+            throw std::invalid_argument("Invalid location byte in a packed state");
+        }
+    }
+
+    for (int color = 0; color < nb_homes; ++color) {
+        int nb_home = homes_[color];
+        for (int value = 1; value <= nb_home; ++value) {
+            if (packed[color * king_value + value - 1] != packed_home)
+                throw std::invalid_argument("Home destination with a gap");
+        }
+        homes_[color] = nb_home > 0 ? color << 4 | nb_home : 0;
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (int index = bottoms[i]; index != none && nb_placed < nb_cards; index = above[index]) {
+            stacks_[i][stack_sizes_[i]++] = byteFromIndex(index);
+            nb_placed++;
+        }
+    }
+
+    // cards sitting on a cycle or on a home/free cell card are never reached
+    if (nb_placed != nb_cards)
+        throw std::invalid_argument("Packed state does not place all cards");
+}
+
+ReplayBoard::CardByte ReplayBoard::top_(int location) const {
+    if (location < first_stack)
+        return free_cells_[location];
+    else if (location < first_home) {
+        int stack = location - first_stack;
+        return stack_sizes_[stack] > 0 ? stacks_[stack][stack_sizes_[stack] - 1] : 0;
+    } else
+        return homes_[location - first_home];
+}
+
+bool ReplayBoard::accepts_(int location, CardByte card) const {
+    CardByte top = top_(location);
+
+    if (location < first_stack)
+        return top == 0;
+    else if (location < first_home)
+        return top == 0 || (isRed(cardColor(top)) != isRed(cardColor(card)) && cardValue(card) == cardValue(top) - 1);
+    else if (top == 0)
+        return cardValue(card) == 1;
+    else
+        return cardColor(card) == cardColor(top) && cardValue(card) == cardValue(top) + 1;
+}
+
+void ReplayBoard::pop_(int location) {
+    if (location < first_stack)
+        free_cells_[location] = 0;
+    else if (location < first_home)
+        stack_sizes_[location - first_stack]--;
+    else {
+        CardByte &top = homes_[location - first_home];
+        top = cardValue(top) > 1 ? top - 1 : 0;
+    }
+}
+
+void ReplayBoard::push_(int location, CardByte card) {
+    if (location < first_stack)
+        free_cells_[location] = card;
+    else if (location < first_home) {
+        int stack = location - first_stack;
+        stacks_[stack][stack_sizes_[stack]++] = card;
+    } else
+        homes_[location - first_home] = card;
+}
+
+bool ReplayBoard::apply(PackedMove move) {
+    int from = move.byte() >> 4;
+    int to = move.byte() & 0xf;
+
+    CardByte card = top_(from);
+    if (card == 0 || !accepts_(to, card))
+        return false;
+
+    pop_(from);
+    push_(to, card);
+    runSafeMoves_();
+
+    return true;
+}
+
+bool ReplayBoard::isHome_(int color, int value) const {
+    for (auto top : homes_) {
+        if (top != 0 && cardColor(top) == color && cardValue(top) >= value)
+            return true;
+    }
+
+    return false;
+}
+
+bool ReplayBoard::couldGoHome_(CardByte card) const {
+    if (cardValue(card) <= 2)
+        return true;
+
+    for (int color = 0; color < 4; ++color) {
+        if (isRed(color) != isRed(cardColor(card)) && !isHome_(color, cardValue(card) - 1))
+            return false;
+    }
+
+    return true;
+}
+
+// same order as safeHomeMoves(): the first free cell or stack whose top
+// card may go home moves to the first home accepting it, until none is left
+void ReplayBoard::runSafeMoves_() {
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int from = 0; from < first_home && !moved; ++from) {
+            CardByte card = top_(from);
+            if (card == 0 || !couldGoHome_(card))
+                continue;
+
+            for (int home = first_home; home < nb_locations; ++home) {
+                if (accepts_(home, card)) {
+                    pop_(from);
+                    push_(home, card);
+                    moved = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool ReplayBoard::isFinal() const {
+    for (int color = 0; color < 4; ++color) {
+        if (!isHome_(color, king_value))
+            return false;
+    }
+
+    return true;
+}
+
+int ReplayBoard::nbCardsHome() const {
+    int nb_home = 0;
+    for (auto top : homes_)
+        nb_home += cardValue(top);
+
+    return nb_home;
+}
+
+GameState ReplayBoard::gameState() const {
+    GameState gs;
+
+    for (int i = 0; i < nb_freecells; ++i) {
+        if (free_cells_[i] != 0)
+            gs.free_cells[i].acceptCard(cardFromByte(free_cells_[i]));
+    }
+
+    for (int i = 0; i < nb_homes; ++i) {
+        for (int value = 1; value <= cardValue(homes_[i]); ++value)
+            gs.homes[i].acceptCard({static_cast<Color>(cardColor(homes_[i])), value});
+    }
+
+    for (int i = 0; i < nb_stacks; ++i) {
+        for (int j = 0; j < stack_sizes_[i]; ++j)
+            gs.stacks[i].forceCard(cardFromByte(stacks_[i][j]));
+    }
+
+    return gs;
+}
+
+bool replaySolves(const SearchState &init_state, const std::vector<SearchAction> &solution) {
+    ReplayBoard board(init_state);
+    for (const auto &action : solution) {
+        if (!board.apply(PackedMove(action)))
+            return false;
+    }
+
+    return board.isFinal();
+}
+
+bool replaySolves(const GameState &init_state, const std::vector<PackedMove> &solution) {
+    ReplayBoard board(init_state);
+    for (auto move : solution) {
+        if (!board.apply(move))
+            return false;
+    }
+
+    return board.isFinal();
+}
@@ -0,0 +1,62 @@
+#ifndef REPLAY_BOARD_H
+#define REPLAY_BOARD_H
+
+#include "game.h"
+#include "packed-move.h"
+#include "packed-state.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Compact FreeCell board for replaying solutions in place.
+// It follows the rules of SearchState::execute() exactly, including the
+// cascade of safe moves to the homes after every move and the positions
+// of the home destinations, but keeps each card in a byte and never
+// allocates, so that checking a move costs a few comparisons.
+class ReplayBoard {
+public:
+    explicit ReplayBoard(const GameState &gs);
+    explicit ReplayBoard(const SearchState &state);
+
+    // Same board as ReplayBoard(unpackState(packed)), without building the GameState.
+    // Throws std::invalid_argument if the bytes do not describe a valid layout.
+    explicit ReplayBoard(const PackedState &packed);
+
+    // Plays the move followed by the safe moves it enables.
+    // Returns false and leaves the board untouched if the move is illegal.
+    bool apply(PackedMove move);
+
+    bool isFinal() const;
+    int nbCardsHome() const;
+
+    GameState gameState() const;
+
+private:
+    // a card is (color << 4 | value), 0 stands for no card
+    using CardByte = std::uint8_t;
+
+    static constexpr int nb_locations = nb_freecells + nb_stacks + nb_homes;
+    static constexpr int first_stack = nb_freecells;
+    static constexpr int first_home = nb_freecells + nb_stacks;
+    static constexpr int max_stack_size = 52;
+
+    CardByte top_(int location) const;
+    bool accepts_(int location, CardByte card) const;
+    void pop_(int location);
+    void push_(int location, CardByte card);
+    bool isHome_(int color, int value) const;
+    bool couldGoHome_(CardByte card) const;
+    void runSafeMoves_();
+
+    std::array<CardByte, nb_freecells> free_cells_;
+    std::array<CardByte, nb_homes> homes_;  // top card of each home
+    std::array<std::array<CardByte, max_stack_size>, nb_stacks> stacks_;
+    std::array<std::uint8_t, nb_stacks> stack_sizes_;
+};
+
+// True if playing the solution from the initial state reaches the final state.
+bool replaySolves(const SearchState &init_state, const std::vector<SearchAction> &solution);
+bool replaySolves(const GameState &init_state, const std::vector<PackedMove> &solution);
+
+#endif
@@ -0,0 +1,53 @@
+#include "results-stream.h"
+
+#include <stdexcept>
+
+ResultsWriter::ResultsWriter(const std::string &path, Format format) :
+        buffer_(buffer_size),
+        format_(format),
+        nb_written_(0) {
+    // the buffer has to be installed before the file is opened
+    out_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+    out_.open(path, std::ios::out | std::ios::trunc);
+    if (!out_)
+        throw std::runtime_error("Cannot open results file '" + path + "'");
+
+    if (format_ == Format::Csv)
+        out_ << "seed,index,solved,solution_length,wall_time_us,nb_expanded,nb_generated,nb_pruned,peak_open,peak_closed,peak_rss\n";
+}
+
+ResultsWriter::~ResultsWriter() {
+    out_.flush();
+}
+
+void ResultsWriter::write(const DealRecord &record) {
+    if (format_ == Format::Jsonl) {
+        out_ << "{\"seed\":" << record.seed <<
+            ",\"index\":" << record.index <<
+            ",\"solved\":" << (record.solved ? "true" : "false") <<
+            ",\"solution_length\":" << record.solution_length <<
+            ",\"wall_time_us\":" << record.wall_time.count() <<
+            ",\"nb_expanded\":" << record.nb_expanded <<
+            ",\"nb_generated\":" << record.nb_generated <<
+            ",\"nb_pruned\":" << record.nb_pruned <<
+            ",\"peak_open\":" << record.peak_open <<
+            ",\"peak_closed\":" << record.peak_closed <<
+            ",\"peak_rss\":" << record.peak_rss <<
+            "}\n";
+    } else {
+        out_ << record.seed << ',' <<
+            record.index << ',' <<
+            (record.solved ? 1 : 0) << ',' <<
+            record.solution_length << ',' <<
+            record.wall_time.count() << ',' <<
+            record.nb_expanded << ',' <<
+            record.nb_generated << ',' <<
+            record.nb_pruned << ',' <<
+            record.peak_open << ',' <<
+            record.peak_closed << ',' <<
+            record.peak_rss << '\n';
+    }
+
+    if (++nb_written_ % flush_period == 0)
+        out_.flush();
+}
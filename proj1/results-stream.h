@@ -0,0 +1,32 @@
+#ifndef RESULTS_STREAM_H
+#define RESULTS_STREAM_H
+
+#include "evaluation-type.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Streams one DealRecord per finished deal into a file, either as JSON lines
+// or as CSV with a header. Writes go through a large stream buffer which is
+// flushed every flush_period records, so that an abort loses only a few.
+class ResultsWriter {
+public:
+    enum class Format {Jsonl, Csv};
+
+    ResultsWriter(const std::string &path, Format format);
+    ~ResultsWriter();
+
+    void write(const DealRecord &record);
+
+private:
+    static constexpr size_t buffer_size = 1 << 16;
+    static constexpr unsigned long flush_period = 64;
+
+    std::vector<char> buffer_;
+    std::ofstream out_;
+    Format format_;
+    unsigned long nb_written_;
+};
+
+#endif
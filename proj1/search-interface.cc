@@ -1,20 +1,31 @@
 #include "search-interface.h"
 #include "game.h"
+#include "mem_watch.h"
+#include "profile.h"
 
 #include <cassert>
 #include <algorithm>
 
 
 unsigned long long SearchState::nbExpanded() {
-    return SearchState::nb_expanded;
+    return SearchState::nb_expanded.load(std::memory_order_relaxed);
 }
 
 bool operator<(const SearchState &a, const SearchState &b) {
     return a.state_ < b.state_;
 }
 
+bool operator==(const SearchState &a, const SearchState &b) {
+    return a.state_ == b.state_;
+}
+
+static SearchState copyState(const SearchState &state) {
+	SUI_PROFILE_SCOPE(ProfilePhase::StateCopy);
+	return state;
+}
+
 SearchState SearchAction::execute(const SearchState& state) const {
-	SearchState new_state(state);
+	SearchState new_state = copyState(state);
 	bool succeeded = new_state.execute(*this);
 	assert(succeeded);
 
@@ -40,21 +51,56 @@ bool SearchState::execute(const SearchAction& action) {
 
 	runSafeMoves_();
 
-    SearchState::nb_expanded++;
+    SearchState::nb_expanded.fetch_add(1, std::memory_order_relaxed);
 
 	return true;
 }
 
-void SearchState::runSafeMoves_() {
+static std::uint8_t storageIndex(const GameState &gs, const CardStorage *storage) {
+	return std::find(gs.all_storage.begin(), gs.all_storage.end(), storage) - gs.all_storage.begin();
+}
+
+bool SearchState::apply(const SearchAction &action, UndoRecord &undo) {
+	undo.moves.clear();
+
+	auto from_ptr = ptrFromLoc(state_, action.from());
+	auto to_ptr = ptrFromLoc(state_, action.to());
+	if (!moveLegal(from_ptr, to_ptr))
+		return false;
+
+	move(const_cast<CardStorage *>(from_ptr), const_cast<CardStorage *>(to_ptr));
+	undo.moves.emplace_back(storageIndex(state_, from_ptr), storageIndex(state_, to_ptr));
+
+	SUI_PROFILE_SCOPE(ProfilePhase::SafeMoves);
 	std::vector<RawMove> safe_moves;
 	while ((safe_moves = safeHomeMoves(state_)), safe_moves.size() > 0) {
-		const CardStorage *from = safe_moves[0].first;
-		const CardStorage *to = safe_moves[0].second;
+		move(const_cast<CardStorage *>(safe_moves[0].first), const_cast<CardStorage *>(safe_moves[0].second));
+		undo.moves.emplace_back(storageIndex(state_, safe_moves[0].first), storageIndex(state_, safe_moves[0].second));
+	}
+
+	SearchState::nb_expanded.fetch_add(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+void SearchState::undo(const UndoRecord &undo) {
+	// cards only ever leave free cells and stacks, so that is where they return
+	for (auto it = undo.moves.rbegin(); it != undo.moves.rend(); ++it) {
+		CardStorage *from = state_.all_storage[it->first];
+		Card card = *state_.all_storage[it->second]->getCard();
 
-		move(const_cast<CardStorage *>(from), const_cast<CardStorage *>(to));
+		if (it->first >= nb_freecells)
+			static_cast<WorkStack *>(from)->forceCard(card);
+		else
+			from->acceptCard(card);
 	}
 }
 
+void SearchState::runSafeMoves_() {
+	SUI_PROFILE_SCOPE(ProfilePhase::SafeMoves);
+	runSafeMoves(state_);
+}
+
 bool SearchState::isFinal() const {
 	for (auto color : colors_list) {
 		if (!cardIsHome(state_, {color, king_value}))
@@ -64,9 +110,14 @@ bool SearchState::isFinal() const {
 	return true;
 }
 
-unsigned long long SearchState::nb_expanded = 0;
+bool SearchState::isDeadEnd() const {
+	return ::isDeadEnd(state_);
+}
+
+std::atomic<unsigned long long> SearchState::nb_expanded{0};
 
 std::vector<SearchAction> SearchState::actions() const {
+	SUI_PROFILE_SCOPE(ProfilePhase::Actions);
 	auto raw_moves = availableMoves(
 		state_.non_homes.begin(),
 		state_.non_homes.end(),
@@ -86,6 +137,27 @@ std::vector<SearchAction> SearchState::actions() const {
 	return moves;
 }
 
+PackedState packState(const SearchState &state) {
+	return packState(state.state_);
+}
+
+HomeOrder homeOrder(const SearchState &state) {
+	return homeOrder(state.state_);
+}
+
+size_t hash(const SearchState &state) {
+	std::uint64_t h = hashPackedState(packState(state.state_));
+
+	// packState() ignores the order of the homes, equality does not
+	for (const auto &home : state.state_.homes) {
+		auto top = home.topCard();
+		h ^= top.has_value() ? static_cast<int>(top->color) + 1 : 0;
+		h *= 0x100000001b3ull;
+	}
+
+	return h;
+}
+
 std::ostream& operator<< (std::ostream& os, const SearchState & state) {
 	os << state.state_;
 	return os;
@@ -95,3 +167,81 @@ std::ostream& operator<< (std::ostream& os, const SearchAction & action) {
 	os << action.from_ << " " << action.to_;
 	return os;
 }
+
+CancellationToken::CancellationToken(std::chrono::milliseconds time_limit, unsigned long long node_limit, MemWatcher *mem_watcher) :
+        deadline_(std::chrono::steady_clock::now() + time_limit),
+        has_deadline_(time_limit > std::chrono::milliseconds::zero()),
+        node_limit_(node_limit),
+        nb_expanded_(0),
+        cancelled_(false),
+        parent_(nullptr),
+        mem_watcher_(mem_watcher),
+        shed_(false),
+        trimmed_(false),
+        rss_after_shed_(0),
+        out_of_memory_(false) {
+}
+
+CancellationToken::CancellationToken(CancellationToken &parent) :
+        CancellationToken(std::chrono::milliseconds::zero(), 0, parent.mem_watcher_) {
+    parent_ = &parent;
+}
+
+void CancellationToken::cancel() {
+    cancelled_.store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed) || (parent_ != nullptr && parent_->cancelled());
+}
+
+bool CancellationToken::expand() {
+    auto nb_expanded = nb_expanded_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    if (node_limit_ > 0 && nb_expanded > node_limit_)
+        cancel();
+    else if (has_deadline_ && nb_expanded % clock_check_period == 0 && std::chrono::steady_clock::now() >= deadline_)
+        cancel();
+    else if (parent_ != nullptr && parent_->expand())
+        cancel();
+
+    return cancelled();
+}
+
+CancellationToken::MemVerdict CancellationToken::memoryCheck() {
+    if (mem_watcher_ == nullptr || !mem_watcher_->underPressure())
+        return MemVerdict::Fine;
+
+    if (!shed_) {
+        shed_ = true;
+        return MemVerdict::Shed;
+    }
+
+    // the allocator keeps the shed memory, so hand back what it can to the
+    // OS and take the RSS sampled right after as the new baseline
+    if (!trimmed_) {
+        trimmed_ = true;
+        mem_watcher_->releaseFreedMemory();
+        rss_after_shed_ = mem_watcher_->lastRSS();
+        return MemVerdict::Fine;
+    }
+
+    // while the search reuses the memory it shed, RSS stays about flat,
+    // only creeping up as freed chunks do not always fit new allocations
+    if (mem_watcher_->lastRSS() <= rss_after_shed_ + rss_after_shed_ / 16)
+        return MemVerdict::Fine;
+
+    out_of_memory_ = true;
+    if (parent_ != nullptr)
+        parent_->out_of_memory_ = true;
+    cancel();
+    return MemVerdict::GiveUp;
+}
+
+bool CancellationToken::outOfMemory() const {
+    return out_of_memory_.load(std::memory_order_relaxed);
+}
+
+unsigned long long CancellationToken::nbExpanded() const {
+    return nb_expanded_.load(std::memory_order_relaxed);
+}
@@ -3,13 +3,22 @@
 
 #include "move.h"
 #include "game.h"
+#include "packed-state.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 class SearchState;
 
 class AStarHeuristicItf;
 
+class MemWatcher;
+
 class SearchAction {
 public:
 	SearchAction(Location from, Location to) : from_(from), to_(to) {} ;
@@ -24,14 +33,28 @@ private:
 	Location to_;
 };
 
+// What SearchState::apply() changed, the move itself and the safe moves
+// following it, as pairs of indices into GameState::all_storage.
+// Reusing one record keeps its capacity, so applying does not allocate for it.
+struct UndoRecord {
+    std::vector<std::pair<std::uint8_t, std::uint8_t>> moves;
+};
+
 class SearchState {
 public:
     explicit SearchState(GameState state) : state_(state) {}
 
 	bool isFinal() const;
+	bool isDeadEnd() const;
 	std::vector<SearchAction> actions() const;
 
 	bool execute(const SearchAction &action);
+
+	// In place alternative to copying the state for every successor:
+	// apply() works as execute() and records how to take the action back,
+	// undo() restores the state from before the matching apply().
+	bool apply(const SearchAction &action, UndoRecord &undo);
+	void undo(const UndoRecord &undo);
     static unsigned long long nbExpanded();
 
     friend std::ostream& operator<< (std::ostream& os, const SearchState & state) ;
@@ -39,18 +62,93 @@ public:
     friend bool operator==(const SearchState &a, const SearchState &b) ;
     friend double compute_heuristic(const SearchState &state, const AStarHeuristicItf &heuristic);
     friend size_t hash(const SearchState &state);
+    friend PackedState packState(const SearchState &state);
+    friend HomeOrder homeOrder(const SearchState &state);
+    friend class ReplayBoard;
+    friend class BidirectionalSearch;
 
 private:
 	void runSafeMoves_();
 	GameState state_;
-    static unsigned long long nb_expanded;
+    static std::atomic<unsigned long long> nb_expanded;  // by all threads
+};
+
+
+// Cooperative cancellation of a single solve.
+// The token fires either when cancel() is called or once the per-deal
+// wall-clock or node budget runs out (zero means unlimited).
+// Strategies call expand() once per expanded node and give up on the deal
+// (returning no solution) as soon as it returns true.
+//
+// The token also relays the memory pressure signal of a MemWatcher.
+// Strategies poll memoryCheck() next to expand(): the first time the soft
+// watermark is seen they are asked to Shed what they can (the closed set)
+// and carry on in a low-memory mode. The shed memory is then trimmed back
+// to the OS and RSS sampled afresh. Once a later sample under pressure
+// shows RSS grown well past that one, shedding no longer helps: the token
+// cancels itself and the deal is given up.
+//
+// Searches of the same deal running side by side each get a child token of
+// the deal's one. A child fires on its own cancel() or with its parent,
+// whose budget all children share, and tells it when it runs out of memory.
+class CancellationToken {
+public:
+    enum class MemVerdict {Fine, Shed, GiveUp};
+
+    CancellationToken() : CancellationToken(std::chrono::milliseconds::zero(), 0) {}
+    CancellationToken(std::chrono::milliseconds time_limit, unsigned long long node_limit, MemWatcher *mem_watcher = nullptr);
+    explicit CancellationToken(CancellationToken &parent);
+
+    void cancel();
+    bool cancelled() const;
+    bool expand();
+
+    MemVerdict memoryCheck();
+    bool outOfMemory() const;
+
+    unsigned long long nbExpanded() const;
+
+private:
+    // reading the clock is much more expensive than counting,
+    // so the deadline is only checked every this many nodes
+    static constexpr unsigned long long clock_check_period = 256;
+
+    std::chrono::steady_clock::time_point deadline_;
+    bool has_deadline_;
+    unsigned long long node_limit_;
+    std::atomic<unsigned long long> nb_expanded_;
+    std::atomic<bool> cancelled_;
+
+    CancellationToken *parent_;
+
+    MemWatcher *mem_watcher_;
+    bool shed_;
+    bool trimmed_;
+    size_t rss_after_shed_;
+    std::atomic<bool> out_of_memory_;
 };
 
+// Statistics of the last solve, reset by the strategy at its start.
+// Expanded nodes are counted by the CancellationToken.
+struct SearchStats {
+    unsigned long long nb_generated = 0;
+    unsigned long long nb_pruned = 0;  // generated states dropped as dead ends
+    unsigned long long nb_closed_hits = 0;  // states dropped as already seen
+    double closed_fp_rate = 0.0;  // of the closed set at the end, if approximate
+    size_t peak_open = 0;
+    size_t peak_closed = 0;
+    std::string winner;  // member of a portfolio which found the solution
+};
 
 class SearchStrategyItf {
 public:
-	virtual std::vector<SearchAction> solve(const SearchState &init_state) =0 ;
+	virtual std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) =0 ;
 	virtual ~SearchStrategyItf() {}
+
+	const SearchStats &stats() const { return stats_; }
+
+protected:
+	SearchStats stats_;
 };
 
 #endif
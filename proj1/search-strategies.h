@@ -2,15 +2,19 @@
 #define SEARCH_STRATEGIES_H
 
 #include "search-interface.h"
+#include "closed-set.h"
 #include "game.h"
+#include "thread-pool.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 class DummySearch : public SearchStrategyItf {
 public:
 	DummySearch(size_t max_depth, size_t nb_attempts);
-	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
 
 private:
 	size_t max_depth_;
@@ -18,24 +22,163 @@ private:
 	std::default_random_engine rng_;
 };
 
+// Randomized rollouts from the deal, restarted after a number of moves
+// following the Luby sequence times rollout_unit (64, 64, 128, 64, ...).
+// Every move is drawn among the successors not visited by the rollout yet,
+// with probabilities by the softmax of how much they lower the heuristic,
+// exp(-delta / temperature). Moves are applied and undone in place.
+// nb_threads threads run rollouts at once, each with its own random engine;
+// the first solution found is taken. At most max_rollouts are made.
+class RandomRestartSearch : public SearchStrategyItf {
+public:
+    RandomRestartSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic,
+                        unsigned nb_threads, size_t rollout_unit,
+                        unsigned long long max_rollouts, double temperature);
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    unsigned nb_threads_;
+    size_t rollout_unit_;
+    unsigned long long max_rollouts_;
+    double temperature_;
+    std::uint64_t seed_;  // of the next solve, so that deals get different rollouts
+};
+
+// Monte Carlo tree search. Every iteration descends the tree by UCT,
+// reward + exploration * sqrt(ln N / n), never to a state already on its
+// way. A leaf reached the second time is expanded; then a playout follows
+// the lowest heuristic (a random move one time in five) for up to
+// playout_depth moves, and its reward, how much lower the heuristic got
+// relative to the deal, is backed up along the way. Nodes are taken from a
+// pool of max_nodes and shared by all paths to the same state (by hash).
+// nb_threads threads grow the tree at once; a node counts as a lost visit
+// from the moment a thread passes it until its reward is backed up, which
+// steers the others elsewhere. It stops with the first solution found, or
+// after max_iterations iterations, each counted as an expanded node.
+class MctsSearch : public SearchStrategyItf {
+public:
+    MctsSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, unsigned nb_threads,
+               size_t max_nodes, unsigned long long max_iterations,
+               size_t playout_depth, double exploration);
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    struct Tree;
+
+    const std::unique_ptr<AStarHeuristicItf> heuristic_;
+    unsigned nb_threads_;
+    size_t max_nodes_;
+    unsigned long long max_iterations_;
+    size_t playout_depth_;
+    double exploration_;
+    std::uint64_t seed_;
+};
+
 
 class BreadthFirstSearch : public SearchStrategyItf {
 public:
-    BreadthFirstSearch(size_t mem_limit) : mem_limit_(mem_limit) {}
-	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+    explicit BreadthFirstSearch(std::unique_ptr<ClosedSetItf> &&closed = std::make_unique<ExactClosedSet>()) :
+        closed_(std::move(closed))
+        {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    const std::unique_ptr<ClosedSetItf> closed_;
+};
+
+// Breadth-first search keeping only a parent index and the move for every
+// node, a few bytes instead of a whole state. States are rebuilt when
+// expanded, replaying moves from the nearest ancestor whose packed state
+// was kept; that is done for every node checkpoint_interval moves deep.
+// Duplicates are detected by 64-bit fingerprints of the states.
+class LeanBreadthFirstSearch : public SearchStrategyItf {
+public:
+    explicit LeanBreadthFirstSearch(int checkpoint_interval) :
+        checkpoint_interval_(checkpoint_interval) {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    int checkpoint_interval_;
+};
+
+// Breadth-first search holding just two layers of (packed) states, the one
+// being expanded and the next one. Duplicates are only looked for among the
+// states of the last nb_layers layers, the older ones are forgotten, so
+// states may be searched again. Moves to home can not be taken back, which
+// keeps that rare. The path to every state is kept as the index of its
+// parent in the previous layer and the move, 5 bytes per state; unlike the
+// two layers of states, this table grows with all the states explored.
+class LayeredBreadthFirstSearch : public SearchStrategyItf {
+public:
+    explicit LayeredBreadthFirstSearch(size_t nb_layers) :
+        nb_layers_(nb_layers) {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
 
 private:
-    size_t mem_limit_;
+    size_t nb_layers_;
 };
 
 class DepthFirstSearch : public SearchStrategyItf {
 public:
-    DepthFirstSearch(int depth_limit, size_t mem_limit) :
-        depth_limit_(depth_limit), mem_limit_(mem_limit) {}
-	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+    DepthFirstSearch(int depth_limit) :
+        depth_limit_(depth_limit) {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
 private:
     int depth_limit_;
-    size_t mem_limit_;
+};
+
+// Iterative deepening: depth-first searches limited to 1, 2, ... moves up
+// to depth_limit, applying and undoing actions on a single state.
+// States on the current path are never entered again. An optional
+// transposition table of tt_size entries remembers states whose search
+// failed with at least as many moves to spare, and skips them.
+class IterativeDeepeningSearch : public SearchStrategyItf {
+public:
+    IterativeDeepeningSearch(int depth_limit, size_t tt_size) :
+        depth_limit_(depth_limit), tt_size_(tt_size) {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    int depth_limit_;
+    size_t tt_size_;
+};
+
+// Breadth-first search from both ends, forward from the deal and backward
+// from the solved position, deepening the smaller frontier by one layer at
+// a time until the two meet (see bidirectional-search.cc).
+class BidirectionalSearch : public SearchStrategyItf {
+public:
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    struct ForwardNode;
+    struct BackwardNode;
+
+    static std::vector<SearchAction> reconstruct_(
+        const SearchState &init_state,
+        const std::vector<ForwardNode> &forward_nodes, std::uint32_t forward_meeting,
+        const std::vector<BackwardNode> &backward_nodes, std::uint32_t backward_meeting
+    );
+};
+
+// Several strategies solving the same deal at once, each in its own thread.
+// The first valid solution is taken and the others are cancelled. They
+// share the budget of the deal; their statistics are summed up, and the
+// name of the member which won is kept in them.
+class PortfolioSearch : public SearchStrategyItf {
+public:
+    struct Member {
+        std::string name;
+        std::unique_ptr<SearchStrategyItf> strategy;
+    };
+
+    explicit PortfolioSearch(std::vector<Member> &&members) :
+        members_(std::move(members)) {}
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
+
+private:
+    std::vector<Member> members_;
 };
 
 
@@ -45,17 +188,28 @@ public:
 };
 
 
+// With expand_threads above 1, every step takes the expand_batch best
+// nodes off the open list and generates and evaluates their successors in
+// parallel; they are merged into the open list afterwards, one by one.
 class AStarSearch : public SearchStrategyItf {
 public:
-    AStarSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic, size_t mem_limit) : 
+    AStarSearch(std::unique_ptr<AStarHeuristicItf> &&heuristic,
+                std::unique_ptr<ClosedSetItf> &&closed = std::make_unique<ExactClosedSet>(),
+                unsigned expand_threads = 1, size_t expand_batch = 1) : 
         heuristic_(std::move(heuristic)),
-        mem_limit_(mem_limit)
+        closed_(std::move(closed)),
+        expand_batch_(expand_batch),
+        pool_(expand_threads > 1 ? std::make_unique<ThreadPool>(expand_threads) : nullptr)
         {}
-	std::vector<SearchAction> solve(const SearchState &init_state) override ;
+	std::vector<SearchAction> solve(const SearchState &init_state, CancellationToken &cancel) override ;
 
 private:
+    std::vector<SearchAction> solveBatched_(const SearchState &init_state, CancellationToken &cancel);
+
     const std::unique_ptr<AStarHeuristicItf> heuristic_;
-    size_t mem_limit_;
+    const std::unique_ptr<ClosedSetItf> closed_;
+    size_t expand_batch_;
+    const std::unique_ptr<ThreadPool> pool_;
 };
 
 // beware, this has been proven to NOT be a valid heuristic!
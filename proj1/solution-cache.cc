@@ -0,0 +1,95 @@
+#include "solution-cache.h"
+#include "packed-move.h"
+
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+static constexpr char cache_magic[8] = {'F', 'C', 'S', 'O', 'L', 'N', 'S', '\0'};
+static constexpr std::uint32_t cache_version = 1;
+static constexpr size_t cache_header_size = 12;
+static constexpr size_t record_header_size = sizeof(PackedState) + 2;
+
+SolutionCache::SolutionCache(const std::string &path) {
+    bool fresh = !std::filesystem::exists(path) || std::filesystem::file_size(path) == 0;
+
+    if (!fresh) {
+        log_ = std::make_unique<MappedFile>(path);
+        if (log_->size() < cache_header_size || std::memcmp(log_->data(), cache_magic, sizeof(cache_magic)) != 0)
+            throw std::runtime_error("'" + path + "' is not a solution cache");
+        const std::uint8_t *version = log_->data() + sizeof(cache_magic);
+        if ((version[0] | version[1] << 8 | version[2] << 16 | static_cast<std::uint32_t>(version[3]) << 24) != cache_version)
+            throw std::runtime_error("'" + path + "' has an unsupported solution cache version");
+
+        // drop a record torn by an interrupted append, so that new ones follow a clean log
+        size_t valid_size = cache_header_size + index_(log_->data() + cache_header_size, log_->size() - cache_header_size);
+        if (valid_size < log_->size())
+            std::filesystem::resize_file(path, valid_size);
+    }
+
+    out_.open(path, std::ios::binary | std::ios::app);
+    if (!out_)
+        throw std::runtime_error("Cannot open solution cache '" + path + "'");
+
+    if (fresh) {
+        std::uint8_t header[cache_header_size] = {};
+        std::memcpy(header, cache_magic, sizeof(cache_magic));
+        header[8] = cache_version;
+        out_.write(reinterpret_cast<const char *>(header), sizeof(header));
+        out_.flush();
+    }
+}
+
+size_t SolutionCache::index_(const std::uint8_t *data, size_t size) {
+    size_t offset = 0;
+    while (offset + record_header_size <= size) {
+        const std::uint8_t *record = data + offset;
+        size_t nb_moves = record[sizeof(PackedState)] | record[sizeof(PackedState) + 1] << 8;
+        if (offset + record_header_size + nb_moves > size)
+            break;
+
+        PackedState deal;
+        std::memcpy(deal.data(), record, deal.size());
+        index_map_[deal] = Entry{record + record_header_size, nb_moves};
+
+        offset += record_header_size + nb_moves;
+    }
+
+    return offset;
+}
+
+std::optional<std::vector<SearchAction>> SolutionCache::find(const SearchState &init_state) const {
+    auto it = index_map_.find(packState(init_state));
+    if (it == index_map_.end())
+        return std::nullopt;
+
+    std::vector<SearchAction> solution;
+    solution.reserve(it->second.nb_moves);
+    for (size_t i = 0; i < it->second.nb_moves; ++i) {
+        solution.push_back(PackedMove(it->second.moves[i]).action());
+    }
+
+    return solution;
+}
+
+void SolutionCache::store(const SearchState &init_state, const std::vector<SearchAction> &solution) {
+    if (solution.size() > 0xffff)
+        return;  // does not fit the record, not worth caching anyway
+
+    auto deal = packState(init_state);
+    std::vector<std::uint8_t> record(deal.begin(), deal.end());
+    record.push_back(solution.size() & 0xff);
+    record.push_back(solution.size() >> 8);
+    for (const auto &action : solution)
+        record.push_back(PackedMove(action).byte());
+
+    out_.write(reinterpret_cast<const char *>(record.data()), record.size());
+    out_.flush();
+
+    appended_.push_back(std::move(record));
+    index_map_[deal] = Entry{appended_.back().data() + record_header_size, solution.size()};
+}
+
+size_t SolutionCache::size() const {
+    return index_map_.size();
+}
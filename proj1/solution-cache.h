@@ -0,0 +1,52 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include "search-interface.h"
+#include "mapped-file.h"
+#include "packed-state.h"
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Persistent store of solutions keyed by the packed initial state of a deal.
+//
+// The file is an append-only log: an 8-byte magic "FCSOLNS" + NUL and a
+// little-endian uint32 version, then records of the 52-byte packed deal,
+// a little-endian uint16 number of moves and one PackedMove byte per move.
+// On opening, the existing log is
+// memory-mapped and indexed by the hash of the packed deal; new solutions
+// are appended to the file and kept in memory. A later record for the
+// same deal supersedes the earlier ones.
+//
+// Solutions are returned as stored; callers are expected to verify them.
+class SolutionCache {
+public:
+    explicit SolutionCache(const std::string &path);
+
+    std::optional<std::vector<SearchAction>> find(const SearchState &init_state) const;
+    void store(const SearchState &init_state, const std::vector<SearchAction> &solution);
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        const std::uint8_t *moves;
+        size_t nb_moves;
+    };
+
+    // returns the size of the well-formed prefix of the log
+    size_t index_(const std::uint8_t *data, size_t size);
+
+    std::unique_ptr<MappedFile> log_;
+    std::deque<std::vector<std::uint8_t>> appended_;
+    std::unordered_map<PackedState, Entry, PackedStateHash> index_map_;
+    std::ofstream out_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "solution-optimizer.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// moves leading from init_state to the last visit of each state along the solution
+static std::vector<SearchAction> cutLoops(const SearchState &init_state, const std::vector<SearchAction> &solution) {
+    std::vector<size_t> hashes{hash(init_state)};
+    SearchState state(init_state);
+    for (const auto &action : solution) {
+        state.execute(action);
+        hashes.push_back(hash(state));
+    }
+
+    std::unordered_map<size_t, size_t> last_visit;
+    for (size_t i = 0; i < hashes.size(); ++i)
+        last_visit[hashes[i]] = i;
+
+    std::vector<SearchAction> shortened;
+    for (size_t i = last_visit[hashes[0]]; i < solution.size(); i = last_visit[hashes[i + 1]])
+        shortened.push_back(solution[i]);
+
+    return shortened;
+}
+
+static std::vector<SearchAction> takeShortcuts(const SearchState &init_state, const std::vector<SearchAction> &solution, int window) {
+    std::vector<SearchState> states{init_state};
+    std::unordered_map<size_t, size_t> index;  // no state repeats once the loops are cut
+    index.emplace(hash(init_state), 0);
+    for (const auto &action : solution) {
+        states.push_back(action.execute(states.back()));
+        index.emplace(hash(states.back()), states.size() - 1);
+    }
+
+    std::vector<SearchAction> shortened;
+    size_t i = 0;
+    while (i < solution.size()) {
+        // breadth-first from state i, remembering the furthest state of the solution reached
+        size_t best = i + 1;
+        std::vector<SearchAction> best_moves{solution[i]};
+
+        std::vector<std::pair<SearchState, std::vector<SearchAction>>> layer{{states[i], {}}};
+        std::unordered_set<size_t> seen{hash(states[i])};
+        for (int depth = 1; depth <= window && !layer.empty(); ++depth) {
+            std::vector<std::pair<SearchState, std::vector<SearchAction>>> next_layer;
+            for (const auto &[state, moves] : layer) {
+                for (const auto &action : state.actions()) {
+                    SearchState next = action.execute(state);
+                    auto h = hash(next);
+                    if (!seen.insert(h).second)
+                        continue;
+
+                    auto next_moves = moves;
+                    next_moves.push_back(action);
+
+                    auto it = index.find(h);
+                    if (it != index.end() && it->second > best && it->second - i > next_moves.size() && next == states[it->second]) {
+                        best = it->second;
+                        best_moves = next_moves;
+                    }
+
+                    if (depth < window)
+                        next_layer.emplace_back(std::move(next), std::move(next_moves));
+                }
+            }
+            layer = std::move(next_layer);
+        }
+
+        shortened.insert(shortened.end(), best_moves.begin(), best_moves.end());
+        i = best;
+    }
+
+    return shortened;
+}
+
+std::vector<SearchAction> shortenSolution(const SearchState &init_state, const std::vector<SearchAction> &solution, int window) {
+    auto shortened = cutLoops(init_state, solution);
+    if (window > 0)
+        shortened = takeShortcuts(init_state, shortened, window);
+
+    SearchState state(init_state);
+    for (const auto &action : shortened) {
+        if (!state.execute(action))
+            return solution;
+    }
+
+    return state.isFinal() && shortened.size() < solution.size() ? shortened : solution;
+}
@@ -0,0 +1,16 @@
+#ifndef SOLUTION_OPTIMIZER_H
+#define SOLUTION_OPTIMIZER_H
+
+#include "search-interface.h"
+
+#include <vector>
+
+// Shortens a solution of init_state in two passes:
+// first, every stretch of moves returning to an earlier state is cut out;
+// then, from every state along the way, a breadth-first search of up to
+// `window` moves looks for a shortcut to a later state of the solution.
+// States are matched by hash(SearchState). The result is replayed and
+// the solution is returned unchanged unless the shorter one solves the deal.
+std::vector<SearchAction> shortenSolution(const SearchState &init_state, const std::vector<SearchAction> &solution, int window) ;
+
+#endif
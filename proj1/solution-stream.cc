@@ -0,0 +1,119 @@
+#include "solution-stream.h"
+#include "mapped-file.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+static constexpr char solutions_magic[8] = {'F', 'C', 'M', 'O', 'V', 'E', 'S', '\0'};
+static constexpr std::uint32_t solutions_version = 1;
+static constexpr size_t solutions_header_size = 12;
+static constexpr size_t record_header_size = 10;
+
+static std::uint64_t readLittleEndian(const std::uint8_t *bytes, int nb_bytes) {
+    std::uint64_t value = 0;
+    for (int i = nb_bytes - 1; i >= 0; --i)
+        value = value << 8 | bytes[i];
+    return value;
+}
+
+static void writeLittleEndian(std::ostream &os, std::uint64_t value, int nb_bytes) {
+    for (int i = 0; i < nb_bytes; ++i)
+        os.put(static_cast<char>(value >> (8 * i) & 0xff));
+}
+
+SolutionWriter::SolutionWriter(const std::string &path, Format format) :
+        format_(format) {
+    out_.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out_)
+        throw std::runtime_error("Cannot open solutions file '" + path + "'");
+
+    if (format_ == Format::Binary) {
+        out_.write(solutions_magic, sizeof(solutions_magic));
+        writeLittleEndian(out_, solutions_version, 4);
+    }
+}
+
+void SolutionWriter::write(unsigned long index, const std::vector<SearchAction> &solution) {
+    if (format_ == Format::Text) {
+        out_ << index;
+        for (const auto &action : solution)
+            out_ << ' ' << moveText(PackedMove(action));
+        out_ << '\n';
+    } else {
+        if (solution.size() > 0xffff)
+            throw std::runtime_error("Solution too long for the binary solutions format");
+
+        writeLittleEndian(out_, index, 8);
+        writeLittleEndian(out_, solution.size(), 2);
+        for (const auto &action : solution)
+            out_.put(static_cast<char>(PackedMove(action).byte()));
+    }
+}
+
+static std::vector<DealSolution> parseBinary(const std::uint8_t *data, size_t size, const std::string &path) {
+    if (size < solutions_header_size || readLittleEndian(data + sizeof(solutions_magic), 4) != solutions_version)
+        throw std::runtime_error("'" + path + "' has an unsupported solutions version");
+
+    std::vector<DealSolution> solutions;
+    size_t offset = solutions_header_size;
+    while (offset < size) {
+        if (offset + record_header_size > size)
+            throw std::runtime_error("'" + path + "' is truncated");
+
+        DealSolution solution;
+        solution.index = readLittleEndian(data + offset, 8);
+        size_t nb_moves = readLittleEndian(data + offset + 8, 2);
+        offset += record_header_size;
+        if (offset + nb_moves > size)
+            throw std::runtime_error("'" + path + "' is truncated");
+
+        solution.moves.reserve(nb_moves);
+        for (size_t i = 0; i < nb_moves; ++i)
+            solution.moves.emplace_back(data[offset + i]);
+        offset += nb_moves;
+
+        solutions.push_back(std::move(solution));
+    }
+
+    return solutions;
+}
+
+static std::vector<DealSolution> parseText(const std::uint8_t *data, size_t size, const std::string &path) {
+    std::istringstream input(std::string(reinterpret_cast<const char *>(data), size));
+    std::vector<DealSolution> solutions;
+    std::string line;
+    for (int line_nb = 1; std::getline(input, line); ++line_nb) {
+        std::istringstream fields(line);
+        DealSolution solution;
+        if (!(fields >> solution.index)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            throw std::runtime_error(path + ":" + std::to_string(line_nb) + ": expected a deal index");
+        }
+
+        std::string move;
+        while (fields >> move) {
+            try {
+                solution.moves.push_back(moveFromText(move));
+            } catch (const std::invalid_argument &err) {
+                throw std::runtime_error(path + ":" + std::to_string(line_nb) + ": " + err.what());
+            }
+        }
+
+        solutions.push_back(std::move(solution));
+    }
+
+    return solutions;
+}
+
+std::vector<DealSolution> readSolutions(const std::string &path) {
+    MappedFile file(path);
+    if (file.size() == 0)
+        return {};
+
+    if (file.size() >= sizeof(solutions_magic) && std::memcmp(file.data(), solutions_magic, sizeof(solutions_magic)) == 0)
+        return parseBinary(file.data(), file.size(), path);
+    else
+        return parseText(file.data(), file.size(), path);
+}
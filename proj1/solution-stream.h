@@ -0,0 +1,39 @@
+#ifndef SOLUTION_STREAM_H
+#define SOLUTION_STREAM_H
+
+#include "packed-move.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Solution of one deal, identified by its index within the run.
+struct DealSolution {
+    unsigned long index;
+    std::vector<PackedMove> moves;
+};
+
+// Writes solutions of solved deals into a file, either as text with one
+// deal per line, its index followed by the moves (see moveText()):
+//   17 3a 1w 38 bw
+// or in binary: an 8-byte magic "FCMOVES" + NUL and a little-endian uint32
+// version, then records of a little-endian uint64 deal index, a uint16
+// number of moves and one PackedMove byte per move.
+class SolutionWriter {
+public:
+    enum class Format {Text, Binary};
+
+    SolutionWriter(const std::string &path, Format format);
+
+    void write(unsigned long index, const std::vector<SearchAction> &solution);
+
+private:
+    std::ofstream out_;
+    Format format_;
+};
+
+// Reads a file written by SolutionWriter, telling the format by its magic.
+// Throws std::runtime_error if the file cannot be read or is malformed.
+std::vector<DealSolution> readSolutions(const std::string &path) ;
+
+#endif
@@ -0,0 +1,162 @@
+#include "solver-factory.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+const std::vector<SolverOption> &solverOptions() {
+    static const std::vector<SolverOption> options = {
+        {"solver", &SolverConfig::solver},
+        {"heuristic", &SolverConfig::heuristic},
+        {"dls-limit", &SolverConfig::dls_limit},
+        {"tt-size", &SolverConfig::tt_size},
+        {"checkpoint-interval", &SolverConfig::checkpoint_interval},
+        {"bfs-layers", &SolverConfig::bfs_layers},
+        {"closed-set", &SolverConfig::closed_set},
+        {"approx-closed-bits", &SolverConfig::approx_closed_bits},
+        {"expand-threads", &SolverConfig::expand_threads},
+        {"expand-batch", &SolverConfig::expand_batch},
+        {"portfolio", &SolverConfig::portfolio},
+        {"restart-threads", &SolverConfig::restart_threads},
+        {"rollout-unit", &SolverConfig::rollout_unit},
+        {"max-rollouts", &SolverConfig::max_rollouts},
+        {"temperature", &SolverConfig::temperature},
+        {"mcts-threads", &SolverConfig::mcts_threads},
+        {"mcts-nodes", &SolverConfig::mcts_nodes},
+        {"mcts-iterations", &SolverConfig::mcts_iterations},
+        {"playout-depth", &SolverConfig::playout_depth},
+        {"exploration", &SolverConfig::exploration},
+    };
+    return options;
+}
+
+void setSolverOption(SolverConfig &config, const SolverOption &option, const std::string &value) {
+    std::visit([&](auto field) {
+        using T = std::decay_t<decltype(config.*field)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            config.*field = value;
+        } else {
+            size_t end = 0;
+            bool in_range = true;
+            T number{};
+            try {
+                if constexpr (std::is_same_v<T, double>) {
+                    number = std::stod(value, &end);
+                } else if constexpr (std::is_same_v<T, int>) {
+                    number = std::stoi(value, &end);
+                } else {
+                    auto wide = std::stoull(value, &end);
+                    in_range = value[0] != '-' && wide <= std::numeric_limits<T>::max();
+                    number = static_cast<T>(wide);
+                }
+            } catch (const std::logic_error &) {
+                end = 0;
+            }
+
+            if (value.empty() || end != value.size() || !in_range)
+                throw std::invalid_argument("Invalid value '" + value + "' of " + option.name);
+            config.*field = number;
+        }
+    }, option.field);
+}
+
+std::unique_ptr<AStarHeuristicItf> makeHeuristic(const std::string &name) {
+    if (name == "nb_not_home") {
+        return std::make_unique<OufOfHome_Pseudo>();
+    } else if (name == "student") {
+        return std::make_unique<StudentHeuristic>();
+    } else {
+        throw std::invalid_argument("Unknown heuristic name '" + name + "'\n"
+            "Supported are: nb_not_home, student");
+    }
+}
+
+std::unique_ptr<ClosedSetItf> makeClosedSet(const SolverConfig &config) {
+    if (config.closed_set == "exact") {
+        return std::make_unique<ExactClosedSet>();
+    } else if (config.closed_set == "delta") {
+        return std::make_unique<DeltaClosedSet>();
+    } else if (config.closed_set == "approx") {
+        return std::make_unique<ApproxClosedSet>(config.approx_closed_bits);
+    } else {
+        throw std::invalid_argument("Unknown closed set name '" + config.closed_set + "'\n"
+            "Supported are: exact, delta, approx");
+    }
+}
+
+static std::unique_ptr<SearchStrategyItf> makePortfolio(const SolverConfig &config) {
+    std::vector<PortfolioSearch::Member> members;
+    std::istringstream specs(config.portfolio);
+    std::string spec;
+    while (std::getline(specs, spec, ',')) {
+        SolverConfig member_config = config;
+        auto colon = spec.find(':');
+        member_config.solver = spec.substr(0, colon);
+        if (colon != std::string::npos)
+            member_config.heuristic = spec.substr(colon + 1);
+
+        if (member_config.solver == "portfolio")
+            throw std::invalid_argument("A portfolio can not be a member of a portfolio");
+        members.push_back({spec, makeSolver(member_config)});
+    }
+
+    if (members.empty())
+        throw std::invalid_argument("Portfolio has no members");
+    return std::make_unique<PortfolioSearch>(std::move(members));
+}
+
+std::unique_ptr<SearchStrategyItf> makeSolver(const SolverConfig &config) {
+    if (config.solver == "dummy") {
+        return std::make_unique<DummySearch>(500, 5);
+    } else if (config.solver == "restarts") {
+        if (config.rollout_unit < 1)
+            throw std::invalid_argument("Rollout unit has to be at least 1");
+        if (!(config.temperature > 0))
+            throw std::invalid_argument("Temperature has to be above 0");
+        unsigned restart_threads = config.restart_threads;
+        if (restart_threads == 0)
+            restart_threads = std::max(1u, std::thread::hardware_concurrency());
+        return std::make_unique<RandomRestartSearch>(makeHeuristic(config.heuristic), restart_threads,
+            config.rollout_unit, config.max_rollouts, config.temperature);
+    } else if (config.solver == "mcts") {
+        if (!(config.exploration > 0))
+            throw std::invalid_argument("Exploration has to be above 0");
+        unsigned mcts_threads = config.mcts_threads;
+        if (mcts_threads == 0)
+            mcts_threads = std::max(1u, std::thread::hardware_concurrency());
+        return std::make_unique<MctsSearch>(makeHeuristic(config.heuristic), mcts_threads,
+            config.mcts_nodes, config.mcts_iterations, config.playout_depth, config.exploration);
+    } else if (config.solver == "bfs") {
+        return std::make_unique<BreadthFirstSearch>(makeClosedSet(config));
+    } else if (config.solver == "bfs_lean") {
+        if (config.checkpoint_interval < 1)
+            throw std::invalid_argument("Checkpoint interval has to be at least 1");
+        return std::make_unique<LeanBreadthFirstSearch>(config.checkpoint_interval);
+    } else if (config.solver == "bfs_layered") {
+        if (config.bfs_layers < 1)
+            throw std::invalid_argument("Number of BFS layers has to be at least 1");
+        return std::make_unique<LayeredBreadthFirstSearch>(config.bfs_layers);
+    } else if (config.solver == "bidir") {
+        return std::make_unique<BidirectionalSearch>();
+    } else if (config.solver == "dfs") {
+        return std::make_unique<DepthFirstSearch>(config.dls_limit);
+    } else if (config.solver == "iddfs") {
+        return std::make_unique<IterativeDeepeningSearch>(config.dls_limit, config.tt_size);
+    } else if (config.solver == "portfolio") {
+        return makePortfolio(config);
+    } else if (config.solver == "a_star") {
+        if (config.expand_batch < 1)
+            throw std::invalid_argument("Expand batch has to be at least 1");
+        unsigned expand_threads = config.expand_threads;
+        if (expand_threads == 0)
+            expand_threads = std::max(1u, std::thread::hardware_concurrency());
+        return std::make_unique<AStarSearch>(makeHeuristic(config.heuristic), makeClosedSet(config),
+            expand_threads, config.expand_batch);
+    } else {
+        throw std::invalid_argument("Unknown solver name '" + config.solver + "'\n"
+            "Supported are: dummy, restarts, mcts, bfs, bfs_lean, bfs_layered, bidir, a_star, dfs, iddfs, portfolio");
+    }
+}
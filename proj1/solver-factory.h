@@ -0,0 +1,68 @@
+#ifndef SOLVER_FACTORY_H
+#define SOLVER_FACTORY_H
+
+#include "search-interface.h"
+#include "search-strategies.h"
+
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Everything needed to build a solver, as given on the command line
+// or in a request to the solver daemon.
+struct SolverConfig {
+    std::string solver = "dummy";
+    std::string heuristic = "nb_not_home";
+    int dls_limit = 1'000'000;
+    size_t tt_size = 1 << 20;  // entries of the iddfs transposition table
+    int checkpoint_interval = 4;  // depth between states kept by bfs_lean
+    int bfs_layers = 3;  // layers bfs_layered looks for duplicates in
+    std::string closed_set = "exact";  // of bfs and a_star
+    int approx_closed_bits = 28;  // log2 of the size of the approximate closed set
+    unsigned expand_threads = 1;  // of a_star, 0 for all cores
+    size_t expand_batch = 16;  // nodes a_star expands at once with more than one thread
+    // members of a portfolio, comma separated solver names, a_star with :heuristic
+    std::string portfolio = "a_star:student,a_star:nb_not_home,dfs";
+    // of restarts, 0 threads for all cores
+    unsigned restart_threads = 1;
+    size_t rollout_unit = 64;
+    unsigned long long max_rollouts = 10'000;
+    double temperature = 1.0;
+    // of mcts, 0 threads for all cores
+    unsigned mcts_threads = 1;
+    size_t mcts_nodes = 1 << 20;
+    unsigned long long mcts_iterations = 1'000'000;
+    size_t playout_depth = 300;
+    double exploration = 1.4;
+};
+
+// A setting of SolverConfig, named as its command line option (without the
+// dashes) and as its key in a request to the solver daemon.
+struct SolverOption {
+    const char *name;
+    std::variant<
+        std::string SolverConfig::*,
+        int SolverConfig::*,
+        unsigned SolverConfig::*,
+        size_t SolverConfig::*,
+        unsigned long long SolverConfig::*,
+        double SolverConfig::*
+    > field;
+};
+
+// every setting of SolverConfig, defaulting to those of SolverConfig{}
+const std::vector<SolverOption> &solverOptions() ;
+
+// Sets the option from its text form, throws std::invalid_argument for a value
+// which is not a number of the option's type.
+void setSolverOption(SolverConfig &config, const SolverOption &option, const std::string &value) ;
+
+// All throw std::invalid_argument, listing the supported names, for an unknown name
+// (makeSolver also for a checkpoint interval, number of layers, expand batch or rollout
+// unit below 1, a temperature or exploration not above 0, and for an empty or nested portfolio).
+std::unique_ptr<AStarHeuristicItf> makeHeuristic(const std::string &name) ;
+std::unique_ptr<ClosedSetItf> makeClosedSet(const SolverConfig &config) ;
+std::unique_ptr<SearchStrategyItf> makeSolver(const SolverConfig &config) ;
+
+#endif
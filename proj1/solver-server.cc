@@ -0,0 +1,355 @@
+#include "solver-server.h"
+#include "packed-move.h"
+#include "packed-state.h"
+#include "replay-board.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// how often blocked threads look at the stop flag
+static constexpr int poll_period_ms = 200;
+
+static unsigned long long parseNumber(const std::string &key, const std::string &value) {
+    size_t end = 0;
+    unsigned long long number = 0;
+    try {
+        number = std::stoull(value, &end);
+    } catch (const std::logic_error &) {
+        end = 0;
+    }
+
+    if (value.empty() || end != value.size() || value[0] == '-')
+        throw std::invalid_argument("Invalid value '" + value + "' of " + key);
+
+    return number;
+}
+
+static PackedState parseHexDeal(const std::string &hex) {
+    PackedState packed;
+    if (hex.size() != 2 * packed.size())
+        throw std::invalid_argument("A packed deal takes " + std::to_string(2 * packed.size()) + " hex digits");
+
+    for (size_t i = 0; i < packed.size(); ++i) {
+        auto digit = [&](char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            throw std::invalid_argument(std::string("Invalid hex digit '") + c + "' in the deal");
+        };
+        packed[i] = digit(hex[2 * i]) << 4 | digit(hex[2 * i + 1]);
+    }
+
+    return packed;
+}
+
+// a request may not take more of the server than it is set up to give
+static void clampToServerLimits(SolverConfig &config, const ServerOptions &options) {
+    for (unsigned *threads : {&config.expand_threads, &config.restart_threads, &config.mcts_threads}) {
+        if (*threads == 0 || *threads > options.max_solver_threads)
+            *threads = options.max_solver_threads;
+    }
+    config.mcts_nodes = std::min(config.mcts_nodes, options.max_mcts_nodes);
+    config.tt_size = std::min(config.tt_size, options.max_tt_size);
+    config.approx_closed_bits = std::min(config.approx_closed_bits, options.max_approx_closed_bits);
+    config.expand_batch = std::min(config.expand_batch, options.max_expand_batch);
+}
+
+// A request can only lower the budget of the server, where 0 means unlimited.
+// Its 0 keeps the server's budget.
+static unsigned long long tighterLimit(unsigned long long requested, unsigned long long server) {
+    if (requested == 0)
+        return server;
+    return server == 0 ? requested : std::min(requested, server);
+}
+
+ServeRequest parseServeRequest(const std::string &line, const ServerOptions &options) {
+    std::istringstream tokens(line);
+    ServeRequest request{"", GameState(), options.config, options.time_limit, options.node_limit};
+    if (!(tokens >> request.id))
+        throw std::invalid_argument("Empty request");
+
+    std::optional<std::string> deal_hex;
+    std::optional<unsigned long long> seed, ms_deal, difficulty;
+
+    std::string token;
+    while (tokens >> token) {
+        auto eq = token.find('=');
+        if (eq == std::string::npos)
+            throw std::invalid_argument("Expected key=value, got '" + token + "'");
+        auto key = token.substr(0, eq);
+        auto value = token.substr(eq + 1);
+
+        if (key == "deal")
+            deal_hex = value;
+        else if (key == "seed")
+            seed = parseNumber(key, value);
+        else if (key == "difficulty") {
+            difficulty = parseNumber(key, value);
+            if (*difficulty > static_cast<unsigned long long>(std::max(options.max_difficulty, 0)))
+                throw std::invalid_argument("Difficulty " + value + " is above the limit of " + std::to_string(options.max_difficulty));
+        }
+        else if (key == "ms-deal")
+            ms_deal = parseNumber(key, value);
+        else if (auto option = std::find_if(solverOptions().begin(), solverOptions().end(),
+                    [&](const auto &option) { return key == option.name; });
+                option != solverOptions().end())
+            setSolverOption(request.config, *option, value);
+        else if (key == "time-limit")
+            request.time_limit = std::chrono::milliseconds(tighterLimit(parseNumber(key, value), options.time_limit.count()));
+        else if (key == "node-limit")
+            request.node_limit = tighterLimit(parseNumber(key, value), options.node_limit);
+        else
+            throw std::invalid_argument("Unknown key '" + key + "'");
+    }
+
+    if (deal_hex.has_value() + seed.has_value() + ms_deal.has_value() != 1)
+        throw std::invalid_argument("Exactly one of deal=, seed= and ms-deal= is needed");
+    clampToServerLimits(request.config, options);
+
+    if (deal_hex.has_value())
+        request.deal = unpackState(parseHexDeal(*deal_hex));
+    else if (ms_deal.has_value())
+        request.deal = MsDealProducer(*ms_deal).produce();
+    else if (!difficulty.has_value())
+        request.deal = RandomProducer(*seed).produce();
+    else
+        request.deal = EasyProducer(*seed, *difficulty).produce();
+
+    return request;
+}
+
+std::string formatServeResponse(const std::string &id, const DealRecord &record, const std::vector<SearchAction> &solution) {
+    std::ostringstream response;
+    response << id << (record.solved ? " solved " : " unsolved ") << record.nb_expanded << ' ' << record.wall_time.count();
+    if (record.solved) {
+        for (const auto &action : solution)
+            response << ' ' << moveText(PackedMove(action));
+    }
+    response << '\n';
+
+    return response.str();
+}
+
+static std::string formatError(const std::string &id, std::string message) {
+    std::replace(message.begin(), message.end(), '\n', ' ');
+    return (id.empty() ? "-" : id) + " error " + message + "\n";
+}
+
+class SolverServer::Connection {
+public:
+    explicit Connection(int fd) : fd_(fd) {}
+    ~Connection() { close(fd_); }
+
+    int fd() const { return fd_; }
+
+    // a client that went away just does not get its responses
+    void send(const std::string &data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return;
+            sent += n;
+        }
+    }
+
+private:
+    int fd_;
+    std::mutex mutex_;
+};
+
+SolverServer::SolverServer(const std::string &socket_path, const ServerOptions &options, MemWatcher *mem_watcher, StrategyEvaluation &report) :
+        socket_path_(socket_path),
+        options_(options),
+        listen_fd_(-1),
+        stop_(false),
+        queue_(options.queue_capacity),
+        mem_watcher_(mem_watcher),
+        report_(report) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path '" + socket_path + "' is too long");
+    std::strcpy(addr.sun_path, socket_path.c_str());
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ == -1)
+        throw std::runtime_error(std::string("Cannot create a socket: ") + std::strerror(errno));
+
+    unlink(socket_path.c_str());  // left behind by a previous server
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1 || listen(listen_fd_, SOMAXCONN) == -1) {
+        std::string reason = std::strerror(errno);
+        close(listen_fd_);
+        throw std::runtime_error("Cannot listen on '" + socket_path + "': " + reason);
+    }
+}
+
+SolverServer::~SolverServer() {
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+}
+
+void SolverServer::stop() {
+    stop_ = true;
+}
+
+void SolverServer::run() {
+    for (unsigned i = 0; i < std::max(1u, options_.nb_workers); ++i)
+        workers_.emplace_back(&SolverServer::work_, this);
+
+    while (!stop_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, poll_period_ms) <= 0)
+            continue;
+
+        reapReaders_(false);
+
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd != -1) {
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            readers_.push_back({std::thread(&SolverServer::readConnection_, this, std::make_shared<Connection>(fd), done), done});
+        }
+    }
+
+    reapReaders_(true);
+
+    queue_.close();
+    for (auto &worker : workers_)
+        worker.join();
+    workers_.clear();
+}
+
+void SolverServer::reapReaders_(bool all) {
+    auto finished = std::partition(readers_.begin(), readers_.end(), [&](const Reader &reader) { return !all && !*reader.done; });
+    for (auto it = finished; it != readers_.end(); ++it)
+        it->thread.join();
+    readers_.erase(finished, readers_.end());
+}
+
+void SolverServer::readConnection_(std::shared_ptr<Connection> connection, std::shared_ptr<std::atomic<bool>> done) {
+    std::string pending;
+    bool skipping = false;  // rest of a line which was too long
+    char buffer[4096];
+
+    while (!stop_) {
+        pollfd pfd{connection->fd(), POLLIN, 0};
+        if (poll(&pfd, 1, poll_period_ms) <= 0)
+            continue;
+
+        ssize_t n = recv(connection->fd(), buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        pending.append(buffer, n);
+
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, end - start);
+            start = end + 1;
+            if (skipping) {
+                skipping = false;
+                continue;
+            }
+            if (line.size() > options_.max_request_length) {
+                connection->send(formatError("", "Request line too long"));
+                continue;
+            }
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.find_first_not_of(" \t") == std::string::npos)
+                continue;
+
+            std::string id;
+            std::istringstream(line) >> id;
+            try {
+                auto request = parseServeRequest(line, options_);
+                if (!queue_.push(Job{std::move(request), connection}))
+                    connection->send(formatError(id, "Server is shutting down"));
+            } catch (const std::invalid_argument &err) {
+                connection->send(formatError(id, err.what()));
+            }
+        }
+        pending.erase(0, start);
+
+        if (pending.size() > options_.max_request_length) {
+            if (!skipping)
+                connection->send(formatError("", "Request line too long"));
+            skipping = true;
+            pending.clear();
+        }
+    }
+
+    *done = true;
+}
+
+void SolverServer::work_() {
+    while (auto job = queue_.pop())
+        job->connection->send(solve_(job->request));
+}
+
+std::string SolverServer::solve_(const ServeRequest &request) {
+    std::unique_ptr<SearchStrategyItf> solver;
+    try {
+        solver = makeSolver(request.config);
+    } catch (const std::invalid_argument &err) {
+        return formatError(request.id, err.what());
+    }
+
+    SearchState init_state(request.deal);
+    CancellationToken cancel(request.time_limit, request.node_limit, mem_watcher_);
+
+#ifdef SUI_PROFILE
+    threadProfile() = {};
+#endif
+
+    // a search allocating beyond what there is fails this request only
+    auto out_of_memory = [&]() {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        report_.nb_failed++;
+        report_.nb_out_of_memory++;
+        return formatError(request.id, "Out of memory");
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<SearchAction> solution;
+    try {
+        solution = solver->solve(init_state, cancel);
+    } catch (const std::bad_alloc &) {
+        return out_of_memory();
+    } catch (const std::length_error &) {
+        return out_of_memory();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    DealRecord record{};
+    record.solved = replaySolves(init_state, solution);
+    record.solution_length = solution.size();
+    record.wall_time = std::chrono::duration_cast<decltype(record.wall_time)>(t1 - t0);
+    recordSearch(record, solver->stats(), cancel);
+
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        addDealRecord(report_, record);
+#ifdef SUI_PROFILE
+        report_.profile += threadProfile();
+#endif
+    }
+
+    if (mem_watcher_ && mem_watcher_->underPressure())
+        mem_watcher_->releaseFreedMemory();
+
+    return formatServeResponse(request.id, record, solution);
+}
@@ -0,0 +1,117 @@
+#ifndef SOLVER_SERVER_H
+#define SOLVER_SERVER_H
+
+#include "bounded-queue.h"
+#include "evaluation-type.h"
+#include "game.h"
+#include "mem_watch.h"
+#include "solver-factory.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ServerOptions {
+    unsigned nb_workers = 1;
+    size_t queue_capacity = 1024;
+    SolverConfig config;
+    std::chrono::milliseconds time_limit{0};
+    unsigned long long node_limit = 0;
+
+    // caps on what a single request may ask for, applied over its settings
+    unsigned max_solver_threads = 1;  // expand, restart and mcts threads of one solve
+    size_t max_mcts_nodes = 1 << 22;
+    size_t max_tt_size = 1 << 24;
+    int max_approx_closed_bits = 32;
+    size_t max_expand_batch = 1024;
+    int max_difficulty = 1000;  // seed= deals of a higher difficulty are rejected
+    size_t max_request_length = 64 * 1024;  // longer lines are answered by an error
+};
+
+// A single deal to solve, parsed from one request line:
+//   <id> key=value ...
+// The deal is given by exactly one of
+//   deal=<104 hex digits>         a PackedState
+//   seed=<n> [difficulty=<d>]     the first deal of EasyProducer(n, d), or of
+//                                 RandomProducer(n) without a difficulty
+//   ms-deal=<n>                   Microsoft deal number n
+// and the solver by the options of solverOptions() (solver=, heuristic=, ...),
+// time-limit= (ms) and node-limit=, which default to the server settings.
+// Sizes above the caps of the server are cut down to them, and the time and
+// node limits of the server are maximums: a request may only ask for less.
+struct ServeRequest {
+    std::string id;
+    GameState deal;
+    SolverConfig config;
+    std::chrono::milliseconds time_limit;
+    unsigned long long node_limit;
+};
+
+// Throws std::invalid_argument describing what is wrong with the line.
+ServeRequest parseServeRequest(const std::string &line, const ServerOptions &options) ;
+
+// Response line for a finished request, one of
+//   <id> solved <nb_expanded> <wall_time_us> <move> ...   (moves as by moveText())
+//   <id> unsolved <nb_expanded> <wall_time_us>
+//   <id> error <message>
+std::string formatServeResponse(const std::string &id, const DealRecord &record, const std::vector<SearchAction> &solution) ;
+
+// Long-running solver listening on a Unix domain socket.
+// Each connection is read by its own thread, which parses request lines and
+// puts them into a bounded queue shared by a pool of workers; once the
+// queue is full, reading a connection waits for the workers to catch up.
+// Reading threads are joined as soon as their client hangs up.
+// Responses are written back to the connection of the request as soon as
+// its deal is done, so they need not come in the order of the requests.
+class SolverServer {
+public:
+    // Throws std::runtime_error if the socket cannot be set up.
+    SolverServer(const std::string &socket_path, const ServerOptions &options, MemWatcher *mem_watcher, StrategyEvaluation &report);
+    ~SolverServer();
+
+    SolverServer(const SolverServer &) = delete;
+    SolverServer &operator=(const SolverServer &) = delete;
+
+    // serves until stop(), then finishes the requests already queued
+    void run();
+
+    // only sets a flag, so it may be called from a signal handler
+    void stop();
+
+private:
+    class Connection;
+
+    struct Job {
+        ServeRequest request;
+        std::shared_ptr<Connection> connection;
+    };
+
+    struct Reader {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    void readConnection_(std::shared_ptr<Connection> connection, std::shared_ptr<std::atomic<bool>> done);
+    void reapReaders_(bool all);
+    void work_();
+    std::string solve_(const ServeRequest &request);
+
+    std::string socket_path_;
+    ServerOptions options_;
+    int listen_fd_;
+    std::atomic<bool> stop_;
+
+    BoundedQueue<Job> queue_;
+    std::vector<Reader> readers_;
+    std::vector<std::thread> workers_;
+
+    MemWatcher *mem_watcher_;
+    std::mutex report_mutex_;
+    StrategyEvaluation &report_;
+};
+
+#endif
@@ -1,10 +1,12 @@
 #include "search-strategies.h"
+#include "profile.h"
 
 #include <chrono>
 #include <thread>
 #include <algorithm>
 
 double compute_heuristic(const SearchState &state, const AStarHeuristicItf &heuristic) {
+    SUI_PROFILE_SCOPE(ProfilePhase::Heuristic);
     return heuristic.distanceLowerBound(state.state_);
 }
 
@@ -15,12 +17,16 @@ DummySearch::DummySearch(size_t max_depth, size_t nb_attempts) :
 	; // just for initializer list	
 }
 
-std::vector<SearchAction> DummySearch::solve(const SearchState &init_state) {
+std::vector<SearchAction> DummySearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	stats_ = {};
 	for (size_t i = 0; i < nb_attempts_; ++i) {
 		std::vector<SearchAction> solution;
 		SearchState working_state(init_state);
 
 		for (size_t depth = 0; depth < max_depth_ ; ++depth) {
+			if (cancel.expand())
+				return {};
+
 			auto actions = working_state.actions();
 
 			// on a dead end
@@ -33,6 +39,7 @@ std::vector<SearchAction> DummySearch::solve(const SearchState &init_state) {
 
 			solution.push_back(action);
 			working_state = action.execute(working_state);
+			stats_.nb_generated++;
 
 			if (working_state.isFinal())
 				return solution;
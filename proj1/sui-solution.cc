@@ -1,15 +1,22 @@
 #include "search-interface.h"
 #include "search-strategies.h"
+#include "packed-move.h"
+#include "packed-state.h"
+#include "fingerprint-set.h"
 #include "card.h"
-#include "memusage.h"
+#include "profile.h"
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iterator>
+#include <optional>
 #include <ostream>
 #include <utility>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <vector>
 #include <iostream>
 #include <sstream>
@@ -17,9 +24,9 @@
 
 class Path { 
   public: 
-    SearchAction action; 
     Path *parent;  // needs to be ptr, reference cannot store NULL
-	Path(SearchAction action, Path* parent = nullptr) : action(action), parent(parent) {}
+    PackedMove action;
+	Path(PackedMove action, Path* parent = nullptr) : parent(parent), action(action) {}
 };
 
 std::vector<SearchAction> ReconstructPath(Path *pathToCurrent)
@@ -29,7 +36,7 @@ std::vector<SearchAction> ReconstructPath(Path *pathToCurrent)
 
 	do
 	{
-		path.push_back(action->action);
+		path.push_back(action->action.action());
 	} while((action = action->parent)->parent != nullptr);
 
 	std::reverse(path.begin(), path.end());
@@ -37,81 +44,358 @@ std::vector<SearchAction> ReconstructPath(Path *pathToCurrent)
 	return path;
 }
 
-std::vector<SearchAction> BreadthFirstSearch::solve(const SearchState &init_state) {
-	std::queue<std::pair<SearchState, Path *>> open;
-	std::set<SearchState> closed;
+std::vector<SearchAction> BreadthFirstSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	std::deque<Path> paths;  // owns all path nodes of this solve
+	std::queue<std::tuple<SearchState, Path *, ClosedSetItf::Handle>> open;
+	bool keep_closed = true;
+	stats_ = {};
+	ClosedSetScope closed_scope(*closed_);
 
-	open.push(std::make_pair(init_state, new Path(SearchAction(init_state.actions()[0]), nullptr)));  // first state
+	paths.emplace_back(PackedMove(), nullptr);
+	open.emplace(init_state, &paths.back(), closed_->insert(init_state, ClosedSetItf::no_handle));  // first state
 	
 	while(!open.empty())
 	{
-		if (getCurrentRSS() + 50000000 >= mem_limit_)
-			return {};
+		switch (cancel.memoryCheck()) {
+			case CancellationToken::MemVerdict::Shed:
+				closed_->clear();  // low-memory mode, duplicates are no longer detected
+				keep_closed = false;
+				break;
+			case CancellationToken::MemVerdict::GiveUp:
+				return {};
+			default:
+				break;
+		}
 
-		auto [currentState, pathToCurrent] = open.front();
+		auto [currentState, pathToCurrent, currentHandle] = open.front();
 
 		if(currentState.isFinal())
 			return ReconstructPath(pathToCurrent);	
 
-		open.pop();
+		SUI_PROFILED(ProfilePhase::OpenList, open.pop());
+
+		if (cancel.expand())
+			return {};
 
 		for(auto &action: currentState.actions())
 		{
 			auto nextState = action.execute(currentState);
-			if (closed.count(nextState))
+			stats_.nb_generated++;
+			if (nextState.isDeadEnd()) {
+				stats_.nb_pruned++;
+				continue;
+			}
+
+			if (SUI_PROFILED(ProfilePhase::ClosedSet, closed_->contains(nextState))) {
+				stats_.nb_closed_hits++;
 				continue;  // action already expanded => skip it
+			}
 
-			closed.insert(nextState);  // OPTIM: save some description of state instead
+			auto nextHandle = ClosedSetItf::no_handle;
+			if (keep_closed)
+				nextHandle = SUI_PROFILED(ProfilePhase::ClosedSet, closed_->insert(nextState, currentHandle));
 
-			open.push(std::make_pair(nextState, new Path(action, pathToCurrent)));
+			paths.emplace_back(PackedMove(action), pathToCurrent);
+			SUI_PROFILED(ProfilePhase::OpenList, open.emplace(nextState, &paths.back(), nextHandle));
 		}	
+
+		stats_.peak_open = std::max(stats_.peak_open, open.size());
+		stats_.peak_closed = std::max(stats_.peak_closed, closed_->size());
+		stats_.closed_fp_rate = closed_->falsePositiveRate();
 	}
 	return {};
 }
 
 
-int PathDepth(Path *pathToCurrent)
+namespace {
+
+constexpr std::uint32_t no_checkpoint = UINT32_MAX;
+
+struct LeanNode {
+	std::uint32_t parent;
+	std::uint32_t checkpoint;  // index of its kept state, or no_checkpoint
+	PackedMove move;
+};
+
+// a state packed with its home order, so that moves replay on it unchanged
+struct KeptState {
+	PackedState packed;
+	HomeOrder home_order;
+
+	explicit KeptState(const SearchState &state) : packed(packState(state)), home_order(homeOrder(state)) {}
+	SearchState unpack() const { return SearchState(unpackState(packed, home_order)); }
+};
+
+std::vector<SearchAction> LeanPath(const std::vector<LeanNode> &nodes, std::uint32_t index)
 {
-	int height = 0;
-	Path *action = pathToCurrent;
+	std::vector<SearchAction> path;
+	for (; index != 0; index = nodes[index].parent)
+		path.push_back(nodes[index].move.action());
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+// replays the moves to the node from its closest ancestor with a checkpoint
+SearchState RebuildState(const std::vector<LeanNode> &nodes, const std::vector<KeptState> &checkpoints, std::uint32_t index)
+{
+	std::vector<PackedMove> moves;
+	for (; nodes[index].checkpoint == no_checkpoint; index = nodes[index].parent)
+		moves.push_back(nodes[index].move);
+
+	SearchState state = checkpoints[nodes[index].checkpoint].unpack();
+	for (auto it = moves.rbegin(); it != moves.rend(); ++it)
+		state.execute(it->action());
+
+	return state;
+}
+
+}
+
+std::vector<SearchAction> LeanBreadthFirstSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	std::vector<LeanNode> nodes;  // in the order of expansion, so it is the open list too
+	std::vector<KeptState> checkpoints;
+	FingerprintSet closed;
+	bool keep_closed = true;
+	stats_ = {};
 
-	while (action->parent != nullptr)
+	if (init_state.isFinal())
+		return {};
+
+	checkpoints.emplace_back(init_state);
+	nodes.push_back({0, 0, PackedMove()});
+	closed.insert(hash(init_state));
+
+	// siblings are expanded one after another, so their parent is rebuilt only once
+	std::optional<SearchState> parent_state;
+	std::uint32_t parent_index = no_checkpoint;
+
+	int depth = 0;
+	size_t layer_end = 1;
+	for (size_t head = 0; head < nodes.size(); ++head)
 	{
-		height++;
-	  	action = action->parent;
+		switch (cancel.memoryCheck()) {
+			case CancellationToken::MemVerdict::Shed:
+				closed.clear();  // low-memory mode, duplicates are no longer detected
+				keep_closed = false;
+				break;
+			case CancellationToken::MemVerdict::GiveUp:
+				return {};
+			default:
+				break;
+		}
+
+		if (head == layer_end) {
+			++depth;
+			layer_end = nodes.size();
+		}
+
+		const LeanNode node = nodes[head];
+		std::optional<SearchState> currentState;
+		if (node.checkpoint != no_checkpoint) {
+			currentState = RebuildState(nodes, checkpoints, head);
+		} else {
+			if (parent_index != node.parent) {
+				parent_state = RebuildState(nodes, checkpoints, node.parent);
+				parent_index = node.parent;
+			}
+			currentState = node.move.action().execute(*parent_state);
+		}
+
+		if (cancel.expand())
+			return {};
+
+		bool keep_checkpoints = (depth + 1) % checkpoint_interval_ == 0;
+		for (auto &action : currentState->actions())
+		{
+			auto nextState = action.execute(*currentState);
+			stats_.nb_generated++;
+			if (nextState.isFinal()) {
+				auto path = LeanPath(nodes, head);
+				path.push_back(action);
+				return path;
+			}
+
+			if (nextState.isDeadEnd()) {
+				stats_.nb_pruned++;
+				continue;
+			}
+
+			std::uint64_t fingerprint = hash(nextState);
+			if (keep_closed) {
+				if (!SUI_PROFILED(ProfilePhase::ClosedSet, closed.insert(fingerprint)))
+					continue;  // already seen
+			}
+
+			std::uint32_t checkpoint = no_checkpoint;
+			if (keep_checkpoints) {
+				checkpoint = checkpoints.size();
+				checkpoints.emplace_back(nextState);
+			}
+			SUI_PROFILED(ProfilePhase::OpenList, nodes.push_back({static_cast<std::uint32_t>(head), checkpoint, PackedMove(action)}));
+		}
+
+		stats_.peak_open = std::max(stats_.peak_open, nodes.size() - head - 1);
+		stats_.peak_closed = std::max(stats_.peak_closed, closed.size());
 	}
+	return {};
+}
+
+
+namespace {
+
+// How the states of a layer were reached. Parent indices and moves are kept
+// apart so that a state takes 5 bytes, a struct of both would be padded to 8.
+struct LayerLinks {
+	std::vector<std::uint32_t> parents;  // index within the previous layer
+	std::vector<PackedMove> moves;
+
+	void push_back(std::uint32_t parent, PackedMove move) {
+		parents.push_back(parent);
+		moves.push_back(move);
+	}
+	size_t size() const { return moves.size(); }
+};
+
+std::vector<SearchAction> LayeredPath(const std::vector<LayerLinks> &layers, std::uint32_t index)
+{
+	std::vector<SearchAction> path;
+	for (size_t layer = layers.size() - 1; layer > 0; --layer) {
+		path.push_back(layers[layer].moves[index].action());
+		index = layers[layer].parents[index];
+	}
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+}
+
+std::vector<SearchAction> LayeredBreadthFirstSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	std::vector<LayerLinks> layers;  // for each layer and state in it, how it was reached
+	std::vector<KeptState> frontier, next_frontier;
+	std::deque<FingerprintSet> seen;  // one set per layer, of the last nb_layers_ of them
+	bool keep_closed = true;
+	stats_ = {};
+
+	if (init_state.isFinal())
+		return {};
+
+	layers.emplace_back();
+	layers.back().push_back(0, PackedMove());
+	frontier.emplace_back(init_state);
+	seen.emplace_back();
+	seen.back().insert(hash(init_state));
+
+	while (!frontier.empty())
+	{
+		layers.emplace_back();
+		seen.emplace_back();
+		if (seen.size() > nb_layers_)
+			seen.pop_front();  // older layers are not looked at anymore
+
+		for (std::uint32_t i = 0; i < frontier.size(); ++i)
+		{
+			switch (cancel.memoryCheck()) {
+				case CancellationToken::MemVerdict::Shed:
+					seen = {FingerprintSet()};  // low-memory mode, duplicates are no longer detected
+					keep_closed = false;
+					break;
+				case CancellationToken::MemVerdict::GiveUp:
+					return {};
+				default:
+					break;
+			}
 
-  	return height;
+			if (cancel.expand())
+				return {};
+
+			SearchState currentState = frontier[i].unpack();
+			for (auto &action : currentState.actions())
+			{
+				auto nextState = action.execute(currentState);
+				stats_.nb_generated++;
+				if (nextState.isFinal()) {
+					layers.back().push_back(i, PackedMove(action));
+					return LayeredPath(layers, layers.back().size() - 1);
+				}
+
+				if (nextState.isDeadEnd()) {
+					stats_.nb_pruned++;
+					continue;
+				}
+
+				if (keep_closed) {
+					std::uint64_t fingerprint = hash(nextState);
+					bool duplicate = SUI_PROFILED(ProfilePhase::ClosedSet, std::any_of(seen.begin(), seen.end(),
+						[fingerprint](const FingerprintSet &layer) { return layer.contains(fingerprint); }));
+					if (duplicate)
+						continue;
+					seen.back().insert(fingerprint);
+				}
+
+				layers.back().push_back(i, PackedMove(action));
+				SUI_PROFILED(ProfilePhase::OpenList, next_frontier.emplace_back(nextState));
+			}
+
+			stats_.peak_open = std::max(stats_.peak_open, frontier.size() - i - 1 + next_frontier.size());
+		}
+
+		size_t nb_seen = 0;
+		for (const auto &layer : seen)
+			nb_seen += layer.size();
+		stats_.peak_closed = std::max(stats_.peak_closed, nb_seen);
+
+		frontier.swap(next_frontier);
+		next_frontier.clear();
+	}
+	return {};
 }
 
-std::vector<SearchAction> DepthFirstSearch::solve(const SearchState &init_state) {
-	std::deque<std::pair<SearchState, Path *>> open;
 
-	open.push_back(std::make_pair(init_state, new Path(init_state.actions()[0], nullptr)));
+std::vector<SearchAction> DepthFirstSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	std::deque<Path> paths;  // owns all path nodes of this solve
+	std::deque<std::tuple<SearchState, Path *, int>> open;  // with the depth, not to walk the path for it
+	stats_ = {};
+
+	paths.emplace_back(PackedMove(), nullptr);
+	open.emplace_back(init_state, &paths.back(), 0);
 	
 	while(!open.empty())
 	{
-		if (getCurrentRSS() + 50000000 >= mem_limit_)
+		// there is nothing to shed, only giving up helps
+		if (cancel.memoryCheck() == CancellationToken::MemVerdict::GiveUp)
 			return {};
 
-		auto [currentState, pathToCurrent] = open.back();
+		auto [currentState, pathToCurrent, depth] = open.back();
 		
 		if(currentState.isFinal())
 			return ReconstructPath(pathToCurrent);
 
-		open.pop_back();
+		SUI_PROFILED(ProfilePhase::OpenList, open.pop_back());
 
-		if (PathDepth(pathToCurrent) == this->depth_limit_)
+		if (depth == this->depth_limit_)
 		  continue;
 
+		if (cancel.expand())
+			return {};
+
 		for(auto &action : currentState.actions())
 		{
 			auto nextState = action.execute(currentState);
+			stats_.nb_generated++;
+			if (nextState.isDeadEnd()) {
+				stats_.nb_pruned++;
+				continue;
+			}
 
-			open.push_back(std::make_pair(nextState, new Path(action, pathToCurrent)));
+			paths.emplace_back(PackedMove(action), pathToCurrent);
+			SUI_PROFILED(ProfilePhase::OpenList, open.emplace_back(nextState, &paths.back(), depth + 1));
 			if (nextState.isFinal())
 				break;
 		}		
+
+		stats_.peak_open = std::max(stats_.peak_open, open.size());
 	}
 	return {};
 }
@@ -199,11 +483,12 @@ double StudentHeuristic::distanceLowerBound(const GameState &state) const {
 class State{ 
   public: 
     SearchState state;
-    SearchAction action;  // PERF: reoder structure elements due to padding
-    unsigned int score;
     State *parent;
+    unsigned int score;
+    ClosedSetItf::Handle closed_handle;  // once expanded
+    PackedMove action;
 
-	State(SearchState state, SearchAction action, double score, State *parent = nullptr) : state(state), action(action), score(score), parent(parent) {}
+	State(SearchState state, PackedMove action, double score, State *parent = nullptr) : state(state), parent(parent), score(score), closed_handle(ClosedSetItf::no_handle), action(action) {}
 };
 
 struct AStarComparator {
@@ -212,50 +497,202 @@ struct AStarComparator {
     }
 };
 
-std::vector<SearchAction> AStarSearch::solve(const SearchState &init_state) {
+std::vector<SearchAction> ReconstructStatePath(State *current)
+{
+	std::vector<SearchAction> path;
+	State *action = current;
+
+	do
+	{
+		path.push_back(action->action.action());
+	} while((action = action->parent)->parent != nullptr);
+
+	std::reverse(path.begin(), path.end());
+
+	return path;
+}
+
+std::vector<SearchAction> AStarSearch::solve(const SearchState &init_state, CancellationToken &cancel) {
+	if (pool_)
+		return solveBatched_(init_state, cancel);
+
+	std::deque<State> nodes;  // owns all search nodes of this solve
   	std::priority_queue<State *, std::deque<State *>, AStarComparator> open;
-	std::set<SearchState> closed;
+	bool keep_closed = true;
+	stats_ = {};
+	ClosedSetScope closed_scope(*closed_);
 
-	open.push(new State(init_state, init_state.actions()[0], compute_heuristic(init_state, *heuristic_), nullptr));
+	nodes.emplace_back(init_state, PackedMove(), compute_heuristic(init_state, *heuristic_), nullptr);
+	open.push(&nodes.back());
 	while (!open.empty())
 	{
-		if (getCurrentRSS() + 50000000 >= mem_limit_)
-			return {};
+		switch (cancel.memoryCheck()) {
+			case CancellationToken::MemVerdict::Shed:
+				closed_->clear();  // low-memory mode, nodes may get re-expanded
+				keep_closed = false;
+				break;
+			case CancellationToken::MemVerdict::GiveUp:
+				return {};
+			default:
+				break;
+		}
 
 		auto current = open.top();
-		open.pop();
+		SUI_PROFILED(ProfilePhase::OpenList, open.pop());
 
-		if (closed.count(current->state))
+		if (SUI_PROFILED(ProfilePhase::ClosedSet, closed_->contains(current->state))) {
+			stats_.nb_closed_hits++;
 			continue;
+		}
 		
-		closed.insert(current->state);
+		if (keep_closed) {
+			auto parentHandle = current->parent != nullptr ? current->parent->closed_handle : ClosedSetItf::no_handle;
+			current->closed_handle = SUI_PROFILED(ProfilePhase::ClosedSet, closed_->insert(current->state, parentHandle));
+		}
 
 
 		if (current->state.isFinal())
-		{
-	  	  	std::vector<SearchAction> path;
-	  	  	State *action = current;
+			return ReconstructStatePath(current);
 
-	  	  	do
-	  	  	{
-		  	  	path.push_back(action->action);
-	  	  	} while((action = action->parent)->parent != nullptr);
-
-	  	  	std::reverse(path.begin(), path.end());
-
-	  	  	return path;
-		}
+		if (cancel.expand())
+			return {};
 
 		for (auto &action : current->state.actions())
 		{
 			SearchState nextState = action.execute(current->state);
-			if (closed.count(nextState))
+			stats_.nb_generated++;
+			if (nextState.isDeadEnd()) {
+				stats_.nb_pruned++;
 				continue;
+			}
+
+			if (SUI_PROFILED(ProfilePhase::ClosedSet, closed_->contains(nextState))) {
+				stats_.nb_closed_hits++;
+				continue;
+			}
 			unsigned int score = compute_heuristic(nextState, *heuristic_) + current->score;
 
-			open.push(new State(nextState, action, score, current));
+			nodes.emplace_back(nextState, PackedMove(action), score, current);
+			SUI_PROFILED(ProfilePhase::OpenList, open.push(&nodes.back()));
+		}
+
+		stats_.peak_open = std::max(stats_.peak_open, open.size());
+		stats_.peak_closed = std::max(stats_.peak_closed, closed_->size());
+		stats_.closed_fp_rate = closed_->falsePositiveRate();
+
+	}
+
+	return {};
+}
+
+
+namespace {
+
+// what a pool thread found out about one successor
+struct Successor {
+	SearchState state;
+	PackedMove action;
+	double heuristic;
+};
+
+struct Expansion {
+	std::vector<Successor> successors;
+	unsigned long long nb_generated;
+	unsigned long long nb_pruned;
+	unsigned long long nb_closed_hits;
+};
+
+}
+
+std::vector<SearchAction> AStarSearch::solveBatched_(const SearchState &init_state, CancellationToken &cancel) {
+	std::deque<State> nodes;  // owns all search nodes of this solve
+  	std::priority_queue<State *, std::deque<State *>, AStarComparator> open;
+	std::vector<State *> batch;
+	std::vector<Expansion> expansions;
+	bool keep_closed = true;
+	stats_ = {};
+	ClosedSetScope closed_scope(*closed_);
+
+	nodes.emplace_back(init_state, PackedMove(), compute_heuristic(init_state, *heuristic_), nullptr);
+	open.push(&nodes.back());
+	while (!open.empty())
+	{
+		switch (cancel.memoryCheck()) {
+			case CancellationToken::MemVerdict::Shed:
+				closed_->clear();  // low-memory mode, nodes may get re-expanded
+				keep_closed = false;
+				break;
+			case CancellationToken::MemVerdict::GiveUp:
+				return {};
+			default:
+				break;
+		}
+
+		// the best nodes not seen yet; the closed set only changes here,
+		// so that the pool threads can read it safely
+		batch.clear();
+		while (!open.empty() && batch.size() < expand_batch_) {
+			auto current = open.top();
+			SUI_PROFILED(ProfilePhase::OpenList, open.pop());
+
+			if (SUI_PROFILED(ProfilePhase::ClosedSet, closed_->contains(current->state))) {
+				stats_.nb_closed_hits++;
+				continue;
+			}
+
+			if (keep_closed) {
+				auto parentHandle = current->parent != nullptr ? current->parent->closed_handle : ClosedSetItf::no_handle;
+				current->closed_handle = SUI_PROFILED(ProfilePhase::ClosedSet, closed_->insert(current->state, parentHandle));
+			}
+
+			if (current->state.isFinal())
+				return ReconstructStatePath(current);
+
+			if (cancel.expand())
+				return {};
+
+			batch.push_back(current);
+		}
+
+		expansions.resize(batch.size());
+		pool_->run(batch.size(), [&](size_t i) {
+			Expansion &expansion = expansions[i];
+			expansion = {};
+			for (auto &action : batch[i]->state.actions())
+			{
+				SearchState nextState = action.execute(batch[i]->state);
+				expansion.nb_generated++;
+				if (nextState.isDeadEnd()) {
+					expansion.nb_pruned++;
+					continue;
+				}
+
+				if (closed_->contains(nextState)) {
+					expansion.nb_closed_hits++;
+					continue;
+				}
+
+				double heuristic = compute_heuristic(nextState, *heuristic_);
+				expansion.successors.push_back({std::move(nextState), PackedMove(action), heuristic});
+			}
+		});
+
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			stats_.nb_generated += expansions[i].nb_generated;
+			stats_.nb_pruned += expansions[i].nb_pruned;
+			stats_.nb_closed_hits += expansions[i].nb_closed_hits;
+
+			for (auto &successor : expansions[i].successors) {
+				unsigned int score = successor.heuristic + batch[i]->score;
+				nodes.emplace_back(std::move(successor.state), successor.action, score, batch[i]);
+				SUI_PROFILED(ProfilePhase::OpenList, open.push(&nodes.back()));
+			}
 		}
 
+		stats_.peak_open = std::max(stats_.peak_open, open.size());
+		stats_.peak_closed = std::max(stats_.peak_closed, closed_->size());
+		stats_.closed_fp_rate = closed_->falsePositiveRate();
 	}
 
 	return {};
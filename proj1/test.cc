@@ -4,8 +4,22 @@
 #include "card-storage.h"
 #include "move.h"
 #include "game.h"
-
+#include "fingerprint-set.h"
+#include "histogram.h"
+#include "packed-state.h"
+#include "packed-move.h"
+#include "replay-board.h"
+#include "search-interface.h"
+#include "search-strategies.h"
+#include "solution-cache.h"
+#include "solution-optimizer.h"
+#include "solver-server.h"
+#include "thread-pool.h"
+
+#include <filesystem>
+#include <numeric>
 #include <sstream>
+#include <thread>
 
 std::string cardRepresentation(const Card &card) {
 	std::stringstream ss;
@@ -31,6 +45,14 @@ std::string workStackRepresentation(const WorkStack &stack) {
 	return ss.str();
 }
 
+// the solution replays move by move and ends in the final state
+void requireSolves(const SearchState &init_state, const std::vector<SearchAction> &solution) {
+	SearchState state(init_state);
+	for (const auto &action : solution)
+		REQUIRE(state.execute(action));
+	REQUIRE(state.isFinal());
+}
+
 TEST_CASE("Card construction and printing tests") {
 	REQUIRE(cardRepresentation({Color::Heart, 1}) == "1h");
 	REQUIRE(cardRepresentation({Color::Heart, 2}) == "2h");
@@ -53,6 +75,9 @@ TEST_CASE("Card construction and printing tests") {
 	REQUIRE(render_color_map.at(Card{Color::Spade, 7}.color) == render_color_map.at(Card{Color::Club, 7}.color));
 	REQUIRE(render_color_map.at(Card{Color::Spade, 7}.color) != render_color_map.at(Card{Color::Heart, 7}.color));
 	REQUIRE(render_color_map.at(Card{Color::Diamond, 7}.color) == render_color_map.at(Card{Color::Heart, 7}.color));
+
+	for (auto color : colors_list)
+		REQUIRE(renderColor(color) == render_color_map.at(color));
 }
 
 TEST_CASE("Card comparison tests") {
@@ -459,3 +484,606 @@ TEST_CASE("Ptr -> location conversion") {
     REQUIRE(locFromPtr(gs, &gs.free_cells[3]) == Location{LocationClass::FreeCells, 3});
 }
 
+
+TEST_CASE("Histogram percentiles") {
+	LogHistogram histogram;
+	REQUIRE(histogram.percentile(50) == 0);
+
+	for (std::uint64_t i = 1; i <= 100; ++i)
+		histogram.record(i);
+
+	REQUIRE(histogram.count() == 100);
+	REQUIRE(histogram.max() == 100);
+	REQUIRE(histogram.percentile(10) == 10);
+	REQUIRE(histogram.percentile(50) >= 50);
+	REQUIRE(histogram.percentile(50) <= 53);
+	REQUIRE(histogram.percentile(100) == 100);
+
+	histogram.record(30'000'000);
+	REQUIRE(histogram.percentile(100) == 30'000'000);
+	REQUIRE(histogram.percentile(99) <= 100 + 100 / 16);
+}
+
+TEST_CASE("Histogram merging") {
+	LogHistogram a, b;
+	for (std::uint64_t i = 0; i < 1000; ++i)
+		a.record(i);
+	for (std::uint64_t i = 1000; i < 2000; ++i)
+		b.record(i);
+
+	a += b;
+	REQUIRE(a.count() == 2000);
+	REQUIRE(a.max() == 1999);
+
+	auto median = a.percentile(50);
+	REQUIRE(median >= 999);
+	REQUIRE(median <= 999 + 999 / 16);
+}
+
+TEST_CASE("Packed state round trip") {
+	RandomProducer random_producer(42);
+	EasyProducer easy_producer(42, 10);
+
+	for (int i = 0; i < 20; ++i) {
+		GameState random_deal = random_producer.produce();
+		REQUIRE(unpackState(packState(random_deal)) == random_deal);
+
+		GameState easy_deal = easy_producer.produce();
+		REQUIRE(unpackState(packState(easy_deal)) == easy_deal);
+	}
+}
+
+TEST_CASE("Packed state ignores home order and rejects garbage") {
+	GameState a, b;
+	a.homes[0].acceptCard({Color::Club, 1});
+	b.homes[2].acceptCard({Color::Club, 1});
+	REQUIRE_FALSE(a == b);
+	REQUIRE(packState(a)[cardIndex({Color::Club, 1})] == packed_home);
+
+	PackedState garbage;
+	garbage.fill(packed_stack_bottom);
+	REQUIRE_THROWS_AS(unpackState(garbage), std::invalid_argument);
+
+	GameState solved;
+	for (int i = 0; i < nb_homes; ++i)
+		for (int value = 1; value <= king_value; ++value)
+			solved.homes[(i + 1) % nb_homes].acceptCard({colors_list[i], value});
+	REQUIRE_FALSE(unpackState(packState(solved)) == solved);
+	REQUIRE(unpackState(packState(solved), homeOrder(solved)) == solved);
+}
+
+TEST_CASE("Microsoft deal numbering") {
+	GameState gs;
+	initializeMsDeal(&gs, 1);
+
+	REQUIRE(workStackRepresentation(gs.stacks[0]) == "Jd Kd 2s 4c 3s 6d 6s");
+	REQUIRE(workStackRepresentation(gs.stacks[3]) == "Jc 5s Qd Qh 10h Qs 6h");
+	REQUIRE(workStackRepresentation(gs.stacks[7]) == "5h 3h 3c 7s 7d 10c");
+
+	MsDealProducer producer(1);
+	REQUIRE(producer.produce() == gs);
+	REQUIRE_FALSE(producer.produce() == gs);
+}
+
+TEST_CASE("Packed move round trip") {
+	for (int from = 0; from < 16; ++from) {
+		for (int to = 0; to < 16; ++to) {
+			PackedMove move(static_cast<std::uint8_t>(from << 4 | to));
+			REQUIRE(PackedMove(move.action()) == move);
+			REQUIRE(moveFromText(moveText(move)) == move);
+		}
+	}
+
+	PackedMove move(SearchAction({LocationClass::Stacks, 2}, {LocationClass::FreeCells, 0}));
+	REQUIRE(moveText(move) == "3a");
+	REQUIRE(move.to() == Location{LocationClass::FreeCells, 0});
+	REQUIRE(moveText(PackedMove(SearchAction({LocationClass::FreeCells, 1}, {LocationClass::Homes, 3}))) == "bz");
+	REQUIRE_THROWS_AS(moveFromText("9a"), std::invalid_argument);
+	REQUIRE_THROWS_AS(moveFromText("1"), std::invalid_argument);
+}
+
+TEST_CASE("Solution cache survives reopening") {
+	struct RemoveOnExit {
+		std::filesystem::path path;
+		~RemoveOnExit() { std::filesystem::remove(path); }
+	} file{std::filesystem::temp_directory_path() / "sui-test-solution-cache.log"};
+	const std::string path = file.path.string();
+	std::filesystem::remove(file.path);
+
+	EasyProducer producer(42, 10);
+	SearchState solved_deal(producer.produce());
+	SearchState other_deal(producer.produce());
+	std::vector<SearchAction> solution{
+		{{LocationClass::Stacks, 0}, {LocationClass::FreeCells, 1}},
+		{{LocationClass::FreeCells, 1}, {LocationClass::Homes, 3}},
+	};
+
+	{
+		SolutionCache cache(path);
+		REQUIRE_FALSE(cache.find(solved_deal).has_value());
+		cache.store(solved_deal, solution);
+	}
+
+	SolutionCache cache(path);
+	REQUIRE(cache.size() == 1);
+	REQUIRE_FALSE(cache.find(other_deal).has_value());
+
+	auto found = cache.find(solved_deal);
+	REQUIRE(found.has_value());
+	std::ostringstream expected, actual;
+	for (const auto &action : solution)
+		expected << action << "\n";
+	for (const auto &action : *found)
+		actual << action << "\n";
+	REQUIRE(actual.str() == expected.str());
+}
+
+TEST_CASE("Replay board follows SearchState") {
+	RandomProducer random_producer(7);
+	EasyProducer easy_producer(7, 10);
+	std::default_random_engine rng(7);
+
+	for (int deal = 0; deal < 20; ++deal) {
+		GameState gs = deal % 2 ? random_producer.produce() : easy_producer.produce();
+		REQUIRE(SearchState(ReplayBoard(packState(gs)).gameState()) == SearchState(unpackState(packState(gs))));
+
+		SearchState state(gs);
+		ReplayBoard board(gs);
+		for (int step = 0; step < 200 && !state.isFinal(); ++step) {
+			// mostly legal moves, so that the game progresses, with illegal ones mixed in
+			auto actions = state.actions();
+			PackedMove move(static_cast<std::uint8_t>(rng() & 0xff));
+			if (!actions.empty() && rng() % 4 != 0)
+				move = PackedMove(actions[rng() % actions.size()]);
+
+			REQUIRE(board.apply(move) == state.execute(move.action()));
+			REQUIRE(SearchState(board.gameState()) == state);
+			REQUIRE(board.isFinal() == state.isFinal());
+		}
+	}
+
+	PackedState garbage;
+	garbage.fill(packed_stack_bottom);
+	REQUIRE_THROWS_AS(ReplayBoard(garbage), std::invalid_argument);
+}
+
+TEST_CASE("Serve requests parsing") {
+	ServerOptions options;
+	options.config.solver = "a_star";
+	options.time_limit = std::chrono::milliseconds(100);
+
+	auto by_seed = parseServeRequest("7 seed=42 difficulty=10 node-limit=500", options);
+	REQUIRE(by_seed.id == "7");
+	REQUIRE(by_seed.deal == EasyProducer(42, 10).produce());
+	REQUIRE(by_seed.config.solver == "a_star");
+	REQUIRE(by_seed.time_limit == std::chrono::milliseconds(100));
+	REQUIRE(by_seed.node_limit == 500);
+
+	// the server's budget is a maximum, a request's 0 keeps it
+	REQUIRE(parseServeRequest("t seed=1 time-limit=0", options).time_limit == std::chrono::milliseconds(100));
+	REQUIRE(parseServeRequest("t seed=1 time-limit=50", options).time_limit == std::chrono::milliseconds(50));
+	REQUIRE(parseServeRequest("t seed=1 time-limit=5000", options).time_limit == std::chrono::milliseconds(100));
+
+	GameState gs;
+	initializeMsDeal(&gs, 11982);
+	std::ostringstream hex;
+	for (auto byte : packState(gs))
+		hex << "0123456789abcdef"[byte >> 4] << "0123456789abcdef"[byte & 0xf];
+	auto by_bytes = parseServeRequest("x deal=" + hex.str() + " solver=bfs", options);
+	REQUIRE(by_bytes.deal == unpackState(packState(gs)));
+	REQUIRE(by_bytes.config.solver == "bfs");
+
+	auto tuned = parseServeRequest("z seed=1 dls-limit=-1 tt-size=4096 temperature=0.5", options);
+	REQUIRE(tuned.config.dls_limit == -1);
+	REQUIRE(tuned.config.tt_size == 4096);
+	REQUIRE(tuned.config.temperature == 0.5);
+
+	// sizes are cut down to the server's caps
+	auto greedy = parseServeRequest("g ms-deal=1 tt-size=100000000000000 approx-closed-bits=40 expand-batch=1000000 mcts-nodes=1000000000 expand-threads=0", options);
+	REQUIRE(greedy.config.tt_size == options.max_tt_size);
+	REQUIRE(greedy.config.approx_closed_bits == options.max_approx_closed_bits);
+	REQUIRE(greedy.config.expand_batch == options.max_expand_batch);
+	REQUIRE(greedy.config.mcts_nodes == options.max_mcts_nodes);
+	REQUIRE(greedy.config.expand_threads == options.max_solver_threads);
+	REQUIRE(parseServeRequest("y ms-deal=11982", options).deal == gs);
+
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 ms-deal=1", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=-1", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 deal=00", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 colour=red", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 expand-threads=-1", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 mcts-threads=4294967296", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 temperature=warm", options), std::invalid_argument);
+	REQUIRE_THROWS_AS(parseServeRequest("1 seed=1 difficulty=4294967296", options), std::invalid_argument);
+}
+
+TEST_CASE("Bidirectional search solves easy deals") {
+	EasyProducer producer(3, 8);
+	BidirectionalSearch search;
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = search.solve(init_state, cancel);
+
+		requireSolves(init_state, solution);
+	}
+}
+
+TEST_CASE("Dead end detection") {
+	GameState solved;
+	for (size_t i = 0; i < colors_list.size(); ++i)
+		for (int value = 1; value <= king_value; ++value)
+			solved.homes[i].acceptCard({colors_list[i], value});
+	REQUIRE_FALSE(isDeadEnd(solved));
+
+	// only red cards on top, none of them an ace
+	GameState stuck;
+	for (int i = 0; i < nb_freecells; ++i)
+		stuck.free_cells[i].acceptCard({Color::Diamond, king_value - i});
+	int stack = 0;
+	for (auto color : colors_list)
+		for (int value = 1; value <= king_value; ++value) {
+			bool on_top = (color == Color::Heart && value > 5) || (color == Color::Diamond && value > 9);
+			if (!on_top)
+				stuck.stacks[stack++ % nb_stacks].forceCard({color, value});
+		}
+	for (int i = 0; i < nb_stacks; ++i)
+		stuck.stacks[i].forceCard({Color::Heart, king_value - i});
+	REQUIRE(isDeadEnd(stuck));
+
+	// a single empty free cell gives a way out
+	stuck.free_cells[0].getCard();
+	REQUIRE_FALSE(isDeadEnd(stuck));
+}
+
+TEST_CASE("Shortened solutions still solve the deal") {
+	EasyProducer producer(3, 20);
+	DummySearch search(500, 5);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = search.solve(init_state, cancel);
+
+		// a detour through a free cell and back is cut out
+		std::vector<SearchAction> detour;
+		if (!solution.empty()) {
+			SearchState first(init_state);
+			for (const auto &action : first.actions()) {
+				if (action.to().cl != LocationClass::FreeCells || action.from().cl != LocationClass::Stacks)
+					continue;
+				std::vector<SearchAction> candidate{action, SearchAction(action.to(), action.from())};
+				SearchState state(init_state);
+				if (state.execute(candidate[0]) && state.execute(candidate[1]) && state == init_state) {
+					detour = candidate;
+					solution.insert(solution.begin(), detour.begin(), detour.end());
+					break;
+				}
+			}
+		}
+
+		for (int window = 0; window <= 2; ++window) {
+			auto shortened = shortenSolution(init_state, solution, window);
+			REQUIRE(shortened.size() <= solution.size());
+			if (!detour.empty()) {
+				REQUIRE(shortened.size() <= solution.size() - 2);
+				REQUIRE_FALSE((shortened.size() >= 2 &&
+					PackedMove(shortened[0]) == PackedMove(detour[0]) &&
+					PackedMove(shortened[1]) == PackedMove(detour[1])));
+			}
+
+			if (solution.empty())
+				REQUIRE(shortened.empty());
+			else
+				requireSolves(init_state, shortened);
+		}
+	}
+}
+
+TEST_CASE("Apply and undo restore the state") {
+	RandomProducer producer(11);
+	std::default_random_engine rng(11);
+
+	for (int deal = 0; deal < 10; ++deal) {
+		SearchState init_state(producer.produce());
+		SearchState state(init_state);
+		std::vector<UndoRecord> undos;
+
+		for (int step = 0; step < 50; ++step) {
+			auto actions = state.actions();
+			if (actions.empty())
+				break;
+			const auto &action = actions[rng() % actions.size()];
+
+			auto expected = action.execute(state);
+			undos.emplace_back();
+			REQUIRE(state.apply(action, undos.back()));
+			REQUIRE(state == expected);
+		}
+
+		while (!undos.empty()) {
+			state.undo(undos.back());
+			undos.pop_back();
+		}
+		REQUIRE(state == init_state);
+	}
+}
+
+TEST_CASE("Iterative deepening finds shortest solutions") {
+	EasyProducer producer(9, 8);
+	IterativeDeepeningSearch iddfs(20, 1 << 12);
+	BreadthFirstSearch bfs;
+
+	for (int i = 0; i < 20; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = iddfs.solve(init_state, cancel);
+
+		requireSolves(init_state, solution);
+
+		CancellationToken bfs_cancel;
+		REQUIRE(solution.size() == bfs.solve(init_state, bfs_cancel).size());
+	}
+}
+
+TEST_CASE("Lean breadth-first search finds shortest solutions") {
+	EasyProducer producer(7, 8);
+	LeanBreadthFirstSearch lean(3);
+	BreadthFirstSearch bfs;
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = lean.solve(init_state, cancel);
+
+		requireSolves(init_state, solution);
+
+		CancellationToken bfs_cancel;
+		REQUIRE(solution.size() == bfs.solve(init_state, bfs_cancel).size());
+	}
+}
+
+TEST_CASE("Layered breadth-first search finds shortest solutions") {
+	EasyProducer producer(9, 8);
+	LayeredBreadthFirstSearch layered(2);
+	LeanBreadthFirstSearch lean(4);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = layered.solve(init_state, cancel);
+
+		requireSolves(init_state, solution);
+
+		CancellationToken lean_cancel;
+		REQUIRE(solution.size() == lean.solve(init_state, lean_cancel).size());
+	}
+}
+
+TEST_CASE("Delta closed set agrees with the exact one") {
+	EasyProducer producer(11, 20);
+	std::default_random_engine rng(11);
+	DeltaClosedSet delta(4);
+	ExactClosedSet exact;
+
+	for (int i = 0; i < 5; ++i) {
+		SearchState state(producer.produce());
+		auto handle = delta.insert(state, ClosedSetItf::no_handle);
+		exact.insert(state, ClosedSetItf::no_handle);
+
+		for (int step = 0; step < 40; ++step) {
+			auto actions = state.actions();
+			if (actions.empty())
+				break;
+			SearchState next = actions[rng() % actions.size()].execute(state);
+			REQUIRE(delta.contains(next) == exact.contains(next));
+
+			handle = delta.insert(next, handle);
+			exact.insert(next, ClosedSetItf::no_handle);
+			REQUIRE(delta.contains(next));
+			state = std::move(next);
+		}
+	}
+	REQUIRE(delta.size() == exact.size());
+	REQUIRE(delta.dataSize() < delta.size() * 56 / 2);
+
+	delta.clear();
+	REQUIRE(delta.size() == 0);
+
+	EasyProducer easy_producer(13, 8);
+	BreadthFirstSearch exact_bfs;
+	BreadthFirstSearch delta_bfs(std::make_unique<DeltaClosedSet>());
+	for (int i = 0; i < 5; ++i) {
+		SearchState init_state(easy_producer.produce());
+		CancellationToken exact_cancel, delta_cancel;
+		REQUIRE(delta_bfs.solve(init_state, delta_cancel).size() == exact_bfs.solve(init_state, exact_cancel).size());
+		REQUIRE(delta_bfs.stats().peak_closed == exact_bfs.stats().peak_closed);
+	}
+}
+
+TEST_CASE("Concurrent fingerprint set under contention") {
+	// 4096 slots, room for 3072 fingerprints
+	ConcurrentFingerprintSet set(4096 * sizeof(std::uint64_t));
+	REQUIRE(set.capacity() == 4096);
+
+	// every thread inserts all of the same 2048 fingerprints, each is added exactly once
+	constexpr int nb_threads = 8;
+	std::vector<int> nb_added(nb_threads, 0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nb_threads; ++t) {
+		threads.emplace_back([&set, &nb_added, t]() {
+			for (std::uint64_t i = 0; i < 2048; ++i) {
+				std::uint64_t fingerprint = ((i + t * 97) % 2048 + 1) * 0x100000001b3ull;
+				if (set.insert(fingerprint) == ConcurrentFingerprintSet::Insert::Added)
+					nb_added[t]++;
+			}
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+
+	REQUIRE(std::accumulate(nb_added.begin(), nb_added.end(), 0) == 2048);
+	REQUIRE(set.size() == 2048);
+	for (std::uint64_t i = 0; i < 2048; ++i)
+		REQUIRE(set.contains((i + 1) * 0x100000001b3ull));
+	REQUIRE_FALSE(set.contains(2049 * 0x100000001b3ull));
+
+	// beyond three quarters, new ones are refused, the present ones still found
+	for (std::uint64_t i = 2048; i < 3072; ++i)
+		REQUIRE(set.insert((i + 1) * 0x100000001b3ull) == ConcurrentFingerprintSet::Insert::Added);
+	REQUIRE(set.insert(3073 * 0x100000001b3ull) == ConcurrentFingerprintSet::Insert::Full);
+	REQUIRE(set.insert(6 * 0x100000001b3ull) == ConcurrentFingerprintSet::Insert::Present);
+	REQUIRE(set.size() == 3072);
+}
+
+TEST_CASE("Thread pool runs every task once") {
+	ThreadPool pool(4);
+	REQUIRE(pool.size() == 4);
+
+	for (size_t nb_tasks : {0, 1, 3, 1000}) {
+		std::vector<std::atomic<int>> nb_runs(nb_tasks);
+		pool.run(nb_tasks, [&nb_runs](size_t i) { nb_runs[i]++; });
+		REQUIRE(std::all_of(nb_runs.begin(), nb_runs.end(), [](const auto &n) { return n == 1; }));
+	}
+}
+
+TEST_CASE("A* expanding batches in parallel") {
+	EasyProducer producer(19, 15);
+	AStarSearch batched(std::make_unique<StudentHeuristic>(), std::make_unique<ExactClosedSet>(), 3, 8);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = batched.solve(init_state, cancel);
+		REQUIRE_FALSE(solution.empty());
+
+		requireSolves(init_state, solution);
+	}
+}
+
+TEST_CASE("Child cancellation tokens share the budget of their parent") {
+	CancellationToken parent(std::chrono::milliseconds::zero(), 10);
+	CancellationToken a(parent), b(parent);
+
+	for (int i = 0; i < 5; ++i) {
+		REQUIRE_FALSE(a.expand());
+		REQUIRE_FALSE(b.expand());
+	}
+	REQUIRE(a.expand());
+	REQUIRE(b.cancelled());
+	REQUIRE(parent.nbExpanded() == 11);
+
+	CancellationToken other_parent;
+	CancellationToken c(other_parent), d(other_parent);
+	c.cancel();
+	REQUIRE_FALSE(d.cancelled());
+	REQUIRE_FALSE(other_parent.cancelled());
+	other_parent.cancel();
+	REQUIRE(d.cancelled());
+}
+
+TEST_CASE("Portfolio takes the first valid solution") {
+	std::vector<PortfolioSearch::Member> members;
+	members.push_back({"a_star", std::make_unique<AStarSearch>(std::make_unique<StudentHeuristic>())});
+	members.push_back({"bfs", std::make_unique<BreadthFirstSearch>()});
+	members.push_back({"dfs", std::make_unique<DepthFirstSearch>(3)});
+	PortfolioSearch portfolio(std::move(members));
+
+	EasyProducer producer(23, 12);
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = portfolio.solve(init_state, cancel);
+
+		requireSolves(init_state, solution);
+		REQUIRE_FALSE(portfolio.stats().winner.empty());
+	}
+}
+
+TEST_CASE("Random restarts solve easy deals") {
+	EasyProducer producer(29, 15);
+	RandomRestartSearch restarts(std::make_unique<StudentHeuristic>(), 2, 16, 1000, 0.5);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = restarts.solve(init_state, cancel);
+		REQUIRE_FALSE(solution.empty());
+
+		requireSolves(init_state, solution);
+	}
+}
+
+TEST_CASE("MCTS solves easy deals within a small tree") {
+	EasyProducer producer(31, 20);
+	MctsSearch mcts(std::make_unique<StudentHeuristic>(), 2, 256, 100'000, 100, 1.4);
+
+	for (int i = 0; i < 10; ++i) {
+		SearchState init_state(producer.produce());
+		CancellationToken cancel;
+		auto solution = mcts.solve(init_state, cancel);
+		REQUIRE_FALSE(solution.empty());
+		REQUIRE(mcts.stats().peak_closed <= 256);
+
+		requireSolves(init_state, solution);
+	}
+
+	// the budget of the token applies
+	SearchState hard_deal(RandomProducer(31).produce());
+	CancellationToken cancel(std::chrono::milliseconds::zero(), 50);
+	REQUIRE(MctsSearch(std::make_unique<StudentHeuristic>(), 1, 256, 100'000, 1, 1.4).solve(hard_deal, cancel).empty());
+	REQUIRE(cancel.cancelled());
+}
+
+TEST_CASE("Approximate closed set") {
+	EasyProducer producer(17, 20);
+	std::default_random_engine rng(17);
+	ApproxClosedSet approx(16);
+	ExactClosedSet exact;
+	REQUIRE(approx.falsePositiveRate() == 0.0);
+
+	int nb_false_positives = 0;
+	for (int i = 0; i < 20; ++i) {
+		SearchState state(producer.produce());
+		for (int step = 0; step < 100; ++step) {
+			auto actions = state.actions();
+			if (actions.empty())
+				break;
+			SearchState next = actions[rng() % actions.size()].execute(state);
+			if (approx.contains(next) && !exact.contains(next))
+				nb_false_positives++;
+
+			approx.insert(next, ClosedSetItf::no_handle);
+			exact.insert(next, ClosedSetItf::no_handle);
+			REQUIRE(approx.contains(next));
+			state = std::move(next);
+		}
+	}
+
+	// about 2000 states in 2^16 bits
+	REQUIRE(approx.falsePositiveRate() > 0.0);
+	REQUIRE(approx.falsePositiveRate() < 0.001);
+	REQUIRE(nb_false_positives <= 2);
+	REQUIRE(approx.size() + nb_false_positives == exact.size());
+
+	SearchState seen(producer.produce());
+	approx.insert(seen, ClosedSetItf::no_handle);
+	approx.clear();
+	REQUIRE(approx.size() == 0);
+	REQUIRE_FALSE(approx.contains(seen));
+}
+
+TEST_CASE("Fingerprint set") {
+	FingerprintSet set(4);
+	for (std::uint64_t i = 0; i < 1000; ++i)
+		REQUIRE(set.insert(i * 0x100000001ull));
+	REQUIRE_FALSE(set.insert(0));
+	REQUIRE(set.contains(999 * 0x100000001ull));
+	REQUIRE_FALSE(set.contains(1000 * 0x100000001ull));
+	REQUIRE(set.size() == 1000);
+
+	set.clear();
+	REQUIRE_FALSE(set.contains(0));
+	REQUIRE(set.size() == 0);
+}
@@ -0,0 +1,87 @@
+#include "thread-pool.h"
+
+#include <utility>
+
+ThreadPool::ThreadPool(unsigned nb_threads) :
+    task_(nullptr),
+    nb_tasks_(0),
+    next_(0),
+    generation_(0),
+    nb_finished_(0),
+    stopping_(false)
+{
+    for (unsigned i = 1; i < nb_threads; ++i)
+        threads_.emplace_back(&ThreadPool::work_, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &thread : threads_)
+        thread.join();
+}
+
+void ThreadPool::run(size_t nb_tasks, const std::function<void(size_t)> &task) {
+    if (threads_.empty()) {
+        next_.store(0, std::memory_order_relaxed);
+        drain_(nb_tasks, task);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        nb_tasks_ = nb_tasks;
+        next_.store(0, std::memory_order_relaxed);
+        nb_finished_ = 0;
+        generation_++;
+    }
+    wake_.notify_all();
+
+    drain_(nb_tasks, task);
+
+    // every pool thread takes part in every loop, even if it finds nothing
+    // left to do; then none of them can still be looking at this one later
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]{ return nb_finished_ == threads_.size(); });
+
+#ifdef SUI_PROFILE
+    threadProfile() += std::exchange(loop_profile_, {});
+#endif
+}
+
+void ThreadPool::work_() {
+    unsigned long long seen_generation = 0;
+    for (;;) {
+        const std::function<void(size_t)> *task;
+        size_t nb_tasks;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]{ return stopping_ || generation_ != seen_generation; });
+            if (stopping_)
+                return;
+            seen_generation = generation_;
+            task = task_;
+            nb_tasks = nb_tasks_;
+        }
+
+        drain_(nb_tasks, *task);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            nb_finished_++;
+#ifdef SUI_PROFILE
+            loop_profile_ += std::exchange(threadProfile(), {});
+#endif
+        }
+        done_.notify_one();
+    }
+}
+
+void ThreadPool::drain_(size_t nb_tasks, const std::function<void(size_t)> &task) {
+    for (size_t i = next_.fetch_add(1, std::memory_order_relaxed); i < nb_tasks; i = next_.fetch_add(1, std::memory_order_relaxed))
+        task(i);
+}
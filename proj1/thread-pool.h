@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "profile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept for running parallel loops over and over.
+// run() calls task(i) for every i below nb_tasks, spread over the pool and
+// the calling thread, and returns once all of them are done. It is meant
+// to be called by one thread at a time.
+class ThreadPool {
+public:
+    // nb_threads counts the calling thread too, so 1 runs everything in run()
+    explicit ThreadPool(unsigned nb_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void run(size_t nb_tasks, const std::function<void(size_t)> &task);
+    unsigned size() const { return threads_.size() + 1; }
+
+private:
+    void work_();
+    void drain_(size_t nb_tasks, const std::function<void(size_t)> &task);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    // the current loop, guarded by mutex_ except for next_
+    const std::function<void(size_t)> *task_;
+    size_t nb_tasks_;
+    std::atomic<size_t> next_;
+    unsigned long long generation_;
+    unsigned nb_finished_;  // pool threads through with the current loop
+    bool stopping_;
+
+    // what the pool threads timed in the current loop, handed over to the
+    // calling thread at its end (SUI_PROFILE only)
+    PhaseProfile loop_profile_;
+};
+
+#endif